@@ -0,0 +1,226 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "RadioMock.h"
+#include "HostShim.h"
+
+HostUDR UDR0;
+volatile uint8_t  UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L;
+volatile uint8_t  TCCR1A, TCCR1B, TIMSK1, TIFR1, SREG;
+volatile uint16_t ICR1, TCNT1;
+
+SPIClass SPI;
+
+u8  HostShim::mEEPROM[HOST_EEPROM_SIZE];
+u8  HostShim::mPins[HOST_MAX_PINS];
+u8  HostShim::mTxBuf[HOST_TX_BUF_SIZE];
+u16 HostShim::mTxCount;
+u8  HostShim::mRxData;
+
+//
+// shim
+//
+HostUDR &HostUDR::operator=(uint8_t data)
+{
+    HostShim::putTX(data);
+    return *this;
+}
+
+HostUDR::operator uint8_t() const
+{
+    return HostShim::getRX();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    HostShim::writePin(pin, val);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return HostShim::getPin(pin);
+}
+
+unsigned long micros(void)
+{
+    return RadioMock::getTime();
+}
+
+unsigned long millis(void)
+{
+    return RadioMock::getTime() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+    RadioMock::advance(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    RadioMock::advance(us);
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr)
+{
+    return HostShim::getEEPROM()[(size_t)addr % HOST_EEPROM_SIZE];
+}
+
+void eeprom_read_block(void *dst, const void *addr, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        ((uint8_t*)dst)[i] = eeprom_read_byte((const uint8_t*)addr + i);
+}
+
+uint16_t eeprom_read_word(const uint16_t *addr)
+{
+    uint16_t val;
+
+    eeprom_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+uint32_t eeprom_read_dword(const uint32_t *addr)
+{
+    uint32_t val;
+
+    eeprom_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+#define EEPROM_WRITE_uS     3300
+
+static u32 mEEPROMReadyUs;
+
+int eeprom_is_ready(void)
+{
+    return (s32)(HostShim::getTime() - mEEPROMReadyUs) >= 0;
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t val)
+{
+    u8 *cell = &HostShim::getEEPROM()[(size_t)addr % HOST_EEPROM_SIZE];
+
+    if (*cell != val)
+        mEEPROMReadyUs = HostShim::getTime() + EEPROM_WRITE_uS;
+    *cell = val;
+}
+
+void eeprom_update_block(const void *src, void *addr, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        eeprom_update_byte((uint8_t*)addr + i, ((const uint8_t*)src)[i]);
+}
+
+void eeprom_update_word(uint16_t *addr, uint16_t val)
+{
+    eeprom_update_block(&val, addr, sizeof(val));
+}
+
+void eeprom_update_dword(uint32_t *addr, uint32_t val)
+{
+    eeprom_update_block(&val, addr, sizeof(val));
+}
+
+//
+// harness
+//
+void HostShim::reset(void)
+{
+    mEEPROMReadyUs = 0;
+    RadioMock::reset();
+    memset(mPins, 0, sizeof(mPins));
+    mTxCount = 0;
+    mRxData  = 0;
+    UCSR0A = UCSR0B = UCSR0C = UBRR0H = UBRR0L = 0;
+    TCCR1A = TCCR1B = TIMSK1 = TIFR1 = 0;
+    ICR1   = TCNT1 = 0;
+}
+
+void HostShim::eraseEEPROM(void)
+{
+    memset(mEEPROM, 0xff, sizeof(mEEPROM));
+}
+
+u32 HostShim::getTime(void)
+{
+    return RadioMock::getTime();
+}
+
+void HostShim::advance(u32 us)
+{
+    RadioMock::advance(us);
+}
+
+void HostShim::receive(u8 data)
+{
+    mRxData = data;
+    if ((UCSR0B & (1 << RXEN0)) && (UCSR0B & (1 << RXCIE0)))
+        USART_RX_vect();
+}
+
+void HostShim::receive(const u8 *data, u8 size)
+{
+    for (u8 i = 0; i < size; i++)
+        receive(data[i]);
+}
+
+// the vector clears UDRIE0 when the ring is empty
+u16 HostShim::transmit(u8 *buf, u16 max)
+{
+    u16 size;
+
+    while ((UCSR0B & (1 << UDRIE0)) && mTxCount < HOST_TX_BUF_SIZE)
+        USART_UDRE_vect();
+
+    size = (mTxCount < max) ? mTxCount : max;
+    memcpy(buf, mTxBuf, size);
+    memmove(mTxBuf, mTxBuf + size, mTxCount - size);
+    mTxCount -= size;
+    return size;
+}
+
+void HostShim::putTX(u8 data)
+{
+    if (mTxCount < HOST_TX_BUF_SIZE)
+        mTxBuf[mTxCount++] = data;
+}
+
+void HostShim::capture(u16 ticks)
+{
+    ICR1 = ticks;
+    if (TIMSK1 & (1 << ICIE1))
+        TIMER1_CAPT_vect();
+}
+
+u8 HostShim::getPin(u8 pin)
+{
+    return (pin < HOST_MAX_PINS) ? mPins[pin] : 0;
+}
+
+void HostShim::setInput(u8 pin, u8 val)
+{
+    writePin(pin, val);
+}
+
+void HostShim::writePin(u8 pin, u8 val)
+{
+    if (pin < HOST_MAX_PINS)
+        mPins[pin] = val;
+}
@@ -0,0 +1,60 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _HOST_SHIM_H_
+#define _HOST_SHIM_H_
+
+#include "common.h"
+
+#define HOST_EEPROM_SIZE    1024
+#define HOST_TX_BUF_SIZE    256
+#define HOST_MAX_PINS       20
+
+// host side of the shim : virtual time, pins, USART0, Timer1 capture and EEPROM.
+// interrupts do not preempt, the vectors run when the harness calls in here.
+class HostShim
+{
+public:
+    // time 0, pins low, registers and UART cleared. EEPROM is kept like on the chip
+    static void reset(void);
+    static void eraseEEPROM(void);
+    static u8  *getEEPROM(void)             { return mEEPROM; }
+
+    static u32  getTime(void);
+    static void advance(u32 us);
+
+    // bytes from the host run the RX vector, bytes to the host are drained by the UDRE vector
+    static void receive(u8 data);
+    static void receive(const u8 *data, u8 size);
+    static u16  transmit(u8 *buf, u16 max);
+
+    // Timer1 input capture at ticks, runs the capture vector when enabled
+    static void capture(u16 ticks);
+
+    static u8   getPin(u8 pin);
+    static void setInput(u8 pin, u8 val);
+
+    // used by the shim
+    static void putTX(u8 data);
+    static u8   getRX(void)                 { return mRxData; }
+    static void writePin(u8 pin, u8 val);
+
+private:
+    static u8   mEEPROM[HOST_EEPROM_SIZE];
+    static u8   mPins[HOST_MAX_PINS];
+    static u8   mTxBuf[HOST_TX_BUF_SIZE];
+    static u16  mTxCount;
+    static u8   mRxData;
+};
+
+#endif
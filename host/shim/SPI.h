@@ -0,0 +1,36 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _HOST_SPI_H_
+#define _HOST_SPI_H_
+
+#include <stdint.h>
+
+#define SPI_MODE0       0x00
+#define SPI_CLOCK_DIV2  0x04
+
+// the bus goes to RadioMock with RF_MOCK, this one is never used for data
+class SPIClass
+{
+public:
+    void    begin(void)                 { }
+    void    end(void)                   { }
+    void    setBitOrder(uint8_t order)  { }
+    void    setDataMode(uint8_t mode)   { }
+    void    setClockDivider(uint8_t div){ }
+    uint8_t transfer(uint8_t data)      { return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _HOST_EEPROM_H_
+#define _HOST_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 1KB of ATmega328, kept in HostShim
+uint8_t  eeprom_read_byte(const uint8_t *addr);
+uint16_t eeprom_read_word(const uint16_t *addr);
+uint32_t eeprom_read_dword(const uint32_t *addr);
+void     eeprom_read_block(void *dst, const void *addr, size_t size);
+void     eeprom_update_byte(uint8_t *addr, uint8_t val);
+void     eeprom_update_word(uint16_t *addr, uint16_t val);
+void     eeprom_update_dword(uint32_t *addr, uint32_t val);
+void     eeprom_update_block(const void *src, void *addr, size_t size);
+// false for 3.3ms of virtual time after a byte changed, the update calls do not wait
+int      eeprom_is_ready(void);
+
+#endif
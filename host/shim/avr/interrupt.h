@@ -0,0 +1,27 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _HOST_INTERRUPT_H_
+#define _HOST_INTERRUPT_H_
+
+// vectors are plain functions, HostShim calls them
+#define ISR(vector)     extern "C" void vector(void)
+
+extern "C" void USART_RX_vect(void);
+extern "C" void USART_UDRE_vect(void);
+extern "C" void TIMER1_CAPT_vect(void);
+
+static inline void cli(void)    { }
+static inline void sei(void)    { }
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _HOST_IO_H_
+#define _HOST_IO_H_
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU   16000000UL
+#endif
+
+// data register of USART0 : writes go to the host TX queue, reads return the byte being received
+class HostUDR
+{
+public:
+    HostUDR &operator=(uint8_t data);
+    operator uint8_t() const;
+};
+
+extern HostUDR UDR0;
+extern volatile uint8_t  UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L;
+extern volatile uint8_t  TCCR1A, TCCR1B, TIMSK1, TIFR1, SREG;
+extern volatile uint16_t ICR1, TCNT1;
+
+// UCSR0A
+#define U2X0    1
+#define RXC0    7
+// UCSR0B
+#define TXEN0   3
+#define RXEN0   4
+#define UDRIE0  5
+#define RXCIE0  7
+// UCSR0C
+#define UCSZ00  1
+#define UCSZ01  2
+// TCCR1B
+#define CS11    1
+#define ICES1   6
+#define ICNC1   7
+// TIMSK1, TIFR1
+#define ICIE1   5
+#define ICF1    5
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _CHAN_SCALE_H_
+#define _CHAN_SCALE_H_
+
+#include "common.h"
+#include "RFProtocol.h"
+
+// inputs are saturated to this before scaling, +-204% of CHAN_MAX_VALUE
+#define CHAN_SAT_VALUE  1023
+
+static inline s16 clamp(s16 val, s16 lo, s16 hi)
+{
+    if (val < lo)
+        return lo;
+    if (val > hi)
+        return hi;
+    return val;
+}
+
+// x * NUM / DEN by multiplying with a reciprocal made at compile time, AVR has no divider.
+// gives the same result as the division (rounded toward zero) for |x| <= CHAN_SAT_VALUE.
+// MUL is rounded up, the error stays below 1 as long as DEN * CHAN_SAT_VALUE < 2^SHIFT.
+template <u16 NUM, u16 DEN = CHAN_MAX_VALUE>
+class ChanScale
+{
+public:
+    static const u8  SHIFT = (DEN <= 512) ? 19 : ((DEN <= 1024) ? 20 : 21);
+    static const u32 MUL   = (((u32)NUM << SHIFT) + DEN - 1) / DEN;
+
+    static s16 scale(s16 x) {
+        ctassert(MUL <= 0xffffffffUL / CHAN_SAT_VALUE, mul_overflows_u32);
+        u16 mag;
+
+        if (x < 0) {
+            mag = (x < -CHAN_SAT_VALUE) ? CHAN_SAT_VALUE : -x;
+            return -(s16)(((u32)mag * MUL) >> SHIFT);
+        }
+        mag = (x > CHAN_SAT_VALUE) ? CHAN_SAT_VALUE : x;
+        return (s16)(((u32)mag * MUL) >> SHIFT);
+    }
+};
+
+#endif
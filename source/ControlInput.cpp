@@ -0,0 +1,212 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// For Arduino 1.0 and earlier
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "ControlInput.h"
+#include "utils.h"
+
+#define PPM_TICKS_PER_uS    2           // timer1 clk/8 at 16MHz
+#define PPM_SYNC_uS         3000        // longer gaps end a frame
+#define PPM_MIN_uS          800
+#define PPM_MAX_uS          2200
+#define PPM_CENTER_uS       1500        // 1us is one control step, +-500 for 1000 - 2000us
+#define PPM_MIN_CHANNELS    4
+#define PPM_BAD_FRAME       0xff
+
+#define SERIAL_TIMEOUT_uS   500000UL
+#define PPM_TIMEOUT_uS      100000UL
+
+// capture state, owned by the ISR
+static u16 mEdge;
+static u8  mChan;
+static s16 mPulses[RFProtocol::MAX_CHANNEL];
+
+// last complete frame, AETR order as sent by transmitters
+static volatile u8  mFrameReady;
+static volatile u8  mFrameChans;
+static volatile u32 mFrameUs;
+static volatile s16 mFrame[RFProtocol::MAX_CHANNEL];
+
+// same edge to same edge, the polarity of the signal does not matter
+ISR(TIMER1_CAPT_vect)
+{
+    u16 edge  = ICR1;
+    u16 width = (u16)(edge - mEdge) / PPM_TICKS_PER_uS;
+
+    mEdge = edge;
+    if (width >= PPM_SYNC_uS) {
+        if (mChan != PPM_BAD_FRAME && mChan >= PPM_MIN_CHANNELS) {
+            for (u8 i = 0; i < mChan; i++)
+                mFrame[i] = mPulses[i];
+            mFrameChans = mChan;
+            mFrameUs    = micros();
+            mFrameReady = 1;
+        }
+        mChan = 0;
+    } else if (mChan != PPM_BAD_FRAME && width >= PPM_MIN_uS && width <= PPM_MAX_uS) {
+        if (mChan < RFProtocol::MAX_CHANNEL)   // 16 channel trainers, keep the first ones
+            mPulses[mChan++] = width - PPM_CENTER_uS;
+    } else {
+        mChan = PPM_BAD_FRAME;              // dropped until the next sync
+    }
+}
+
+static void startPPM(void)
+{
+    pinMode(PPM_PIN, INPUT);
+    cli();
+    mChan       = PPM_BAD_FRAME;
+    mFrameReady = 0;
+    TCCR1A = 0;
+    TCCR1B = BV(ICNC1) | BV(ICES1) | BV(CS11);
+    TIFR1  = BV(ICF1);
+    TIMSK1 |= BV(ICIE1);
+    sei();
+}
+
+static void stopPPM(void)
+{
+    cli();
+    TIMSK1 &= ~BV(ICIE1);
+    TCCR1B = 0;
+    mFrameReady = 0;
+    sei();
+}
+
+// first and second source of modes
+static const PROGMEM u8 TBL_MODES[ControlInput::MAX_MODE][2] = {
+    { ControlInput::SRC_SERIAL, ControlInput::SRC_NONE   },    // MODE_SERIAL
+    { ControlInput::SRC_PPM,    ControlInput::SRC_NONE   },    // MODE_PPM
+    { ControlInput::SRC_PPM,    ControlInput::SRC_SERIAL },    // MODE_PPM_SERIAL
+    { ControlInput::SRC_SERIAL, ControlInput::SRC_PPM    },    // MODE_SERIAL_PPM
+};
+
+static const u32 TBL_TIMEOUTS[ControlInput::MAX_SRC] = { SERIAL_TIMEOUT_uS, PPM_TIMEOUT_uS };
+
+u8  ControlInput::mMode = ControlInput::MODE_SERIAL;
+u8  ControlInput::mLost = BV(ControlInput::SRC_SERIAL) | BV(ControlInput::SRC_PPM);
+u32 ControlInput::mLastUs[ControlInput::MAX_SRC];
+INPUT_STATS_T ControlInput::mStats[ControlInput::MAX_SRC];
+
+bool ControlInput::setMode(u8 mode)
+{
+    if (mode >= MAX_MODE)
+        return false;
+
+    if (mode != MODE_SERIAL && !isPPMEnabled())
+        startPPM();
+    else if (mode == MODE_SERIAL && isPPMEnabled())
+        stopPPM();
+    mMode = mode;
+    return true;
+}
+
+u8 ControlInput::getSource(void)
+{
+    u32 now = micros();
+    u8  first, second;
+
+    for (u8 i = 0; i < MAX_SRC; i++) {
+        if (!(mLost & BV(i)) && now - mLastUs[i] > TBL_TIMEOUTS[i]) {
+            mLost |= BV(i);
+            mStats[i].timeouts++;
+        }
+    }
+
+    first  = pgm_read_byte(&TBL_MODES[mMode][0]);
+    second = pgm_read_byte(&TBL_MODES[mMode][1]);
+    if (!(mLost & BV(first)))
+        return first;
+    if (second != SRC_NONE && !(mLost & BV(second)))
+        return second;
+    return SRC_NONE;
+}
+
+void ControlInput::updateStats(u8 src, u32 frameUs, u32 now)
+{
+    INPUT_STATS_T *stats = &mStats[src];
+    u32 interval;
+    u32 delay;
+
+    // no interval over a loss of the source
+    if (!(mLost & BV(src))) {
+        interval = frameUs - mLastUs[src];
+        if (interval > 0xffff)
+            interval = 0xffff;
+        stats->interval += ((s32)interval - stats->interval) / 8;
+        if (interval > stats->intervalMax)
+            stats->intervalMax = interval;
+    }
+
+    delay = now - frameUs;
+    if (delay > 0xffff)
+        delay = 0xffff;
+    if (delay > stats->delayMax)
+        stats->delayMax = delay;
+
+    stats->frames++;
+    mLastUs[src] = frameUs;
+    mLost &= ~BV(src);
+}
+
+bool ControlInput::putSerial(void)
+{
+    u32 now = micros();
+
+    updateStats(SRC_SERIAL, now, now);
+    return getSource() == SRC_SERIAL;
+}
+
+u8 ControlInput::fetchPPM(s16 *data)
+{
+    s16 frame[RFProtocol::MAX_CHANNEL];
+    u32 frameUs;
+    u8  size;
+
+    if (!mFrameReady)
+        return 0;
+
+    cli();
+    size    = mFrameChans;
+    frameUs = mFrameUs;
+    for (u8 i = 0; i < size; i++)
+        frame[i] = mFrame[i];
+    mFrameReady = 0;
+    sei();
+
+    updateStats(SRC_PPM, frameUs, micros());
+    if (getSource() != SRC_PPM)
+        return 0;
+
+    for (u8 i = 0; i < size; i++)
+        data[RFProtocol::getControlIdxByOrder(i)] = frame[i];
+    return size;
+}
+
+void ControlInput::getStats(INPUT_STATS_T *stats)
+{
+    memcpy(stats, mStats, sizeof(mStats));
+}
+
+void ControlInput::clearStats(void)
+{
+    memset(mStats, 0, sizeof(mStats));
+}
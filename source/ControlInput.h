@@ -0,0 +1,78 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _CONTROL_INPUT_H_
+#define _CONTROL_INPUT_H_
+
+#include "common.h"
+#include "RFProtocol.h"
+
+// ICP1 of ATmega328, CSN of nRF24L01 in the default wiring. move CSN with CMD_SET_PINS to use PPM
+#define PPM_PIN         8
+
+// frames of one source, sent as is by CMD_GET_INPUT_STATS
+typedef struct {
+    u16  frames;
+    u16  timeouts;      // source lost
+    u16  interval;      // us between frames, running average
+    u16  intervalMax;   // us
+    u16  delayMax;      // us from the end of the frame to the protocol, PPM only
+} INPUT_STATS_T;
+
+// control sources : serial (CMD_INJECT_CONTROLS) and PPM trainer signal on Timer1 input capture.
+// the first source of the mode is used while it is alive, the second one takes over when it is lost.
+class ControlInput
+{
+public:
+    enum {
+        SRC_SERIAL,
+        SRC_PPM,
+        MAX_SRC,
+        SRC_NONE = 0xff
+    };
+
+    enum {
+        MODE_SERIAL,
+        MODE_PPM,
+        MODE_PPM_SERIAL,        // PPM, serial when PPM is lost
+        MODE_SERIAL_PPM,        // serial, PPM when serial is lost
+        MAX_MODE
+    };
+
+    // PPM capture runs only in modes using it
+    static bool setMode(u8 mode);
+    static u8   getMode(void)           { return mMode; }
+    static bool isPPMEnabled(void)      { return mMode != MODE_SERIAL; }
+
+    // source in use, SRC_NONE when all sources of the mode are lost
+    static u8   getSource(void);
+
+    // call for every serial control frame, true if the frame should go to the protocols
+    static bool putSerial(void);
+
+    // new PPM frame in TREA order when PPM is the source in use, returns channel count or 0
+    static u8   fetchPPM(s16 *data);
+
+    static void getStats(INPUT_STATS_T *stats);
+    static void clearStats(void);
+
+private:
+    static void updateStats(u8 src, u32 frameUs, u32 now);
+
+    static u8   mMode;
+    static u8   mLost;
+    static u32  mLastUs[MAX_SRC];
+    static INPUT_STATS_T mStats[MAX_SRC];
+};
+
+#endif
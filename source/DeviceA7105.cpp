@@ -14,27 +14,32 @@
 */
 
 
-#include <SPI.h>
 #include "DeviceA7105.h"
 
+#define CS_HI() deselect();
+#define CS_LO() select();
+#define TX_HI() setPin(mPins->ce, HIGH);
+#define TX_LO() setPin(mPins->ce, LOW);
+#define RX_HI() setPin(mPins->rxen, HIGH);
+#define RX_LO() setPin(mPins->rxen, LOW);
+
 
 void DeviceA7105::initialize()
 {
-    pinMode(PIN_RXEN, OUTPUT);
-    pinMode(PIN_TXEN, OUTPUT);
-    pinMode(PIN_CSN,  OUTPUT);
+    if (mPins->rxen != PIN_NONE)
+        pinMode(mPins->rxen, OUTPUT);
+    if (mPins->ce != PIN_NONE)
+        pinMode(mPins->ce, OUTPUT);
+    pinMode(mPins->csn, OUTPUT);
 
     CS_HI();
     TX_LO();
     RX_LO();
     
-    SPI.begin();
-    SPI.setBitOrder(MSBFIRST);
-    SPI.setDataMode(SPI_MODE0);
-    SPI.setClockDivider(SPI_CLOCK_DIV2);
+    initSPI();
 }
 
-#define PROTOSPI_xfer   SPI.transfer
+#define PROTOSPI_xfer   xfer
 
 u8 DeviceA7105::writeReg(u8 reg, u8 data)
 {
@@ -46,17 +51,34 @@ u8 DeviceA7105::writeReg(u8 reg, u8 data)
     return res;
 }
 
-u8 DeviceA7105::writeData(const u8 *data, u8 length, u8 channel)
+u8 DeviceA7105::writeRegMulti(u8 reg, const u8 *data, u8 length)
+{
+    CS_LO();
+    u8 res = PROTOSPI_xfer(reg);
+    for (u8 i = 0; i < length; i++)
+        PROTOSPI_xfer(*data++);
+    CS_HI();
+
+    return res;
+}
+
+// burst write : reset write pointer, FIFO register and data in one transaction
+u8 DeviceA7105::writeFIFO(const u8 *data, u8 length)
 {
-    u8 i;
-    
     CS_LO();
     PROTOSPI_xfer(A7105_RST_WRPTR);
-    u8 res = PROTOSPI_xfer(0x05);
-    for (i = 0; i < length; i++)
+    u8 res = PROTOSPI_xfer(A7105_05_FIFO_DATA);
+    for (u8 i = 0; i < length; i++)
         PROTOSPI_xfer(*data++);
     CS_HI();
 
+    return res;
+}
+
+u8 DeviceA7105::writeData(const u8 *data, u8 length, u8 channel)
+{
+    u8 res = writeFIFO(data, length);
+
     writeReg(0x0F, channel);
 
     CS_LO();
@@ -94,11 +116,16 @@ u8 DeviceA7105::readReg(u8 reg)
     return data;
 }
 
-u8 DeviceA7105::readData(u8 *data, u8 length)
+// burst read : one transaction for the FIFO register and all data bytes
+u8 DeviceA7105::readFIFO(u8 *data, u8 length)
 {
     u8 res = strobe(A7105_RST_RDPTR);
+
+    CS_LO();
+    PROTOSPI_xfer(0x40 | A7105_05_FIFO_DATA);
     for(u8 i = 0; i < length; i++)
-        *data = readReg(0x05);
+        *data++ = PROTOSPI_xfer(0xFF);
+    CS_HI();
     return res;
 }
 
@@ -162,6 +189,44 @@ void DeviceA7105::setTxRxMode(enum TXRX_State mode)
     }
 }
 
+// start IF (1) or VCO (2) calibration and wait up to 500ms for it
+u8 DeviceA7105::calibrate(u8 mode)
+{
+    writeReg(A7105_02_CALC, mode);
+
+    u32 ms = millis();
+    while(millis() - ms < 500) {
+        if(! readReg(A7105_02_CALC))
+            return 1;
+    }
+    return 0;
+}
+
+void DeviceA7105::getCalibration(u8 *cal)
+{
+    cal[A7105_CALIB_IF]       = readReg(A7105_22_IF_CALIB_I);
+    cal[A7105_CALIB_VCO_CUR]  = readReg(A7105_24_VCO_CURCAL);
+    cal[A7105_CALIB_VCO_BAND] = readReg(A7105_25_VCO_SBCAL_I);
+}
+
+// apply stored calibration values as manual settings
+// returns 0 if the values are failed results or the chip flags them as such
+u8 DeviceA7105::setCalibration(const u8 *cal)
+{
+    if ((cal[A7105_CALIB_IF] & A7105_MASK_FBCF) || (cal[A7105_CALIB_VCO_BAND] & A7105_MASK_VBCF))
+        return 0;
+
+    writeReg(A7105_22_IF_CALIB_I,  A7105_MASK_MFBS | (cal[A7105_CALIB_IF] & 0x0f));
+    writeReg(A7105_24_VCO_CURCAL,  A7105_MASK_MVCS | (cal[A7105_CALIB_VCO_CUR] & 0x0f));
+    writeReg(A7105_25_VCO_SBCAL_I, A7105_MASK_MVBS | (cal[A7105_CALIB_VCO_BAND] & 0x07));
+
+    if (readReg(A7105_22_IF_CALIB_I) & A7105_MASK_FBCF)
+        return 0;
+    if (readReg(A7105_25_VCO_SBCAL_I) & A7105_MASK_VBCF)
+        return 0;
+    return 1;
+}
+
 int DeviceA7105::reset()
 {
     writeReg(0x00, 0x00);
@@ -17,7 +17,8 @@
 #ifndef _DEVICE_A7105_H_
 #define _DEVICE_A7105_H_
 
-#include "Common.h"
+#include "common.h"
+#include "DeviceRF.h"
 #include <Arduino.h>
 #include <avr/pgmspace.h>
 
@@ -88,35 +89,42 @@ enum {
 #define A7105_0F_CHANNEL A7105_0F_PLL_I
 
 enum A7105_MASK {
-    A7105_MASK_FBCF = 1 << 4,
-    A7105_MASK_VBCF = 1 << 3,
+    A7105_MASK_FBCF = 1 << 4,   // read  : IF filter bank calibration failed
+    A7105_MASK_VBCF = 1 << 3,   // read  : VCO band calibration failed
+    A7105_MASK_MFBS = 1 << 4,   // write : manual IF filter bank value
+    A7105_MASK_MVCS = 1 << 4,   // write : manual VCO current value
+    A7105_MASK_MVBS = 1 << 3,   // write : manual VCO band value
 };
 
-class DeviceA7105
-{
-    #define PIN_RXEN      6
-    #define PIN_TXEN      7
-    #define PIN_CSN       10
+// calibration results : IF filter bank, VCO current, VCO band
+enum {
+    A7105_CALIB_IF,
+    A7105_CALIB_VCO_CUR,
+    A7105_CALIB_VCO_BAND,
+    A7105_CALIB_SIZE
+};
 
-    #define CS_HI() digitalWrite(PIN_CSN, HIGH);
-    #define CS_LO() digitalWrite(PIN_CSN, LOW);
-    #define TX_HI() digitalWrite(PIN_TXEN, HIGH);
-    #define TX_LO() digitalWrite(PIN_TXEN, LOW);
-    #define RX_HI() digitalWrite(PIN_RXEN, HIGH);
-    #define RX_LO() digitalWrite(PIN_RXEN, LOW);
-    
+class DeviceA7105 : public DeviceRF<DeviceA7105>
+{
 public:
+    DeviceA7105(const RFPINS_T *pins) : DeviceRF<DeviceA7105>(pins) { }
+
     void initialize();
     int  reset();
     u8   writeReg(u8 reg, u8 data);
+    u8   writeRegMulti(u8 reg, const u8 *data, u8 length);
     u8   writeData(const u8 *data, u8 length, u8 channel);
     u8   writeData_P(const u8 *data, u8 length,  u8 channel);
+    u8   writeFIFO(const u8 *data, u8 length);
     u8   readReg(u8 reg);
-    u8   readData(u8 *data, u8 length);
+    u8   readFIFO(u8 *data, u8 length);
     u8   setRFPower(u8 power);
     void setTxRxMode(enum TXRX_State);
     void writeID(u32 id);
     u8   strobe(u8 state);
+    u8   calibrate(u8 mode);
+    void getCalibration(u8 *cal);
+    u8   setCalibration(const u8 *cal);
     
 // To enable radio transmit after WritePayload you need to turn the radio
 //void PulseCE();
@@ -124,7 +132,6 @@ public:
 private:
 
 // variables
-
 };
 
 #endif
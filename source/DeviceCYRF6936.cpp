@@ -14,27 +14,24 @@
 */
 
 
-#include <SPI.h>
 #include "DeviceCYRF6936.h"
 
+// PA switching is done by XOUT / PACTL of the chip, see setTxRxMode
+#define CS_HI() deselect();
+#define CS_LO() select();
+
 void DeviceCYRF6936::initialize()
 {
-    pinMode(PIN_IRQ, INPUT);
-    pinMode(PIN_CSN, OUTPUT);
-    pinMode(TX_EN, OUTPUT);
-    pinMode(RX_EN, OUTPUT);
+    if (mPins->irq != PIN_NONE)
+        pinMode(mPins->irq, INPUT);
+    pinMode(mPins->csn, OUTPUT);
 
     CS_HI();
-    TX_LO();
-    RX_LO();
 
-    SPI.begin();
-    SPI.setBitOrder(MSBFIRST);
-    SPI.setDataMode(SPI_MODE0);
-    SPI.setClockDivider(SPI_CLOCK_DIV2);
+    initSPI();
 }
 
-#define PROTOSPI_xfer   SPI.transfer
+#define PROTOSPI_xfer   xfer
 
 u8 DeviceCYRF6936::writeReg(u8 reg, u8 data)
 {
@@ -229,7 +226,13 @@ u8 DeviceCYRF6936::readRSSI(u32 dodummyread)
 }
 
 //NOTE: This routine will reset the CRC Seed
-void DeviceCYRF6936::findBestChannels(u8 *channels, u8 len, u8 minspace, u8 min, u8 max)
+// dwell   : time spent on each channel in us, split between the RSSI samples
+// samples : RSSI samples per channel, the noisiest one is kept
+// quiet   : channels at or below this RSSI are clean. the scan stops as soon as
+//           len clean channels minspace apart are found and returns them
+//           (0 : scan every channel)
+void DeviceCYRF6936::findBestChannels(u8 *channels, u8 len, u8 minspace, u8 min, u8 max,
+                                      u16 dwell, u8 samples, u8 quiet)
 {
     #define NUM_FREQ 80
     #define FREQ_OFFSET 4
@@ -239,21 +242,49 @@ void DeviceCYRF6936::findBestChannels(u8 *channels, u8 len, u8 minspace, u8 min,
         min = FREQ_OFFSET;
     if (max > NUM_FREQ)
         max = NUM_FREQ;
+    if (samples == 0)
+        samples = 1;
 
     int i;
     int j;
+    u8  clean = 0;
+    u8  lastClean = 0;
+    u16 interval = dwell / samples;
+
     memset(channels, 0, sizeof(u8) * len);
-    
+    memset(rssi, 0xff, sizeof(rssi));
+
     setCRCSeed(0x0000);
     setTxRxMode(RX_EN);
     //Wait for pre-amp to switch from send to receive
-    delay(1000);
-    for(i = 0; i < NUM_FREQ; i++) {
+    delayMicroseconds(1000);
+    for(i = min; i < max; i++) {
         setRFChannel(i);
         readReg(0x13);
         startReceive();
-        delay(10);
-        rssi[i] = readReg(0x13);
+
+        rssi[i] = 0;
+        for (j = 0; j < samples; j++) {
+            if (interval >= 1000)
+                delay(interval / 1000);
+            delayMicroseconds(interval % 1000);
+            u8 val = readReg(0x13) & 0x1f;
+            if (val > rssi[i])
+                rssi[i] = val;
+        }
+
+        if (quiet && rssi[i] <= quiet && (clean == 0 || i - lastClean >= minspace)) {
+            lastClean = i;
+            channels[clean] = i;
+            if (++clean >= len)
+                break;
+        }
+    }
+
+    // the rssi table is partly filled when the scan stopped early
+    if (clean >= len) {
+        setTxRxMode(TX_EN);
+        return;
     }
 
     for (i = 0; i < len; i++) {
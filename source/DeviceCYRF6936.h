@@ -16,7 +16,8 @@
 #ifndef _DEVICE_CYRF6936_H_
 #define _DEVICE_CYRF6936_H_
 
-#include "Common.h"
+#include "common.h"
+#include "DeviceRF.h"
 #include <Arduino.h>
 #include <avr/pgmspace.h>
 
@@ -76,21 +77,11 @@ enum CYRF_PWR {
     CYRF_PWR_DEFAULT,
 };
 
-class DeviceCYRF6936
+class DeviceCYRF6936 : public DeviceRF<DeviceCYRF6936>
 {
-    #define PIN_RXEN      6
-    #define PIN_TXEN      7
-    #define PIN_CSN       9
-    #define PIN_IRQ       2
-
-    #define CS_HI() digitalWrite(PIN_CSN, HIGH);
-    #define CS_LO() digitalWrite(PIN_CSN, LOW);
-    #define TX_HI() digitalWrite(PIN_TXEN, HIGH);
-    #define TX_LO() digitalWrite(PIN_TXEN, LOW);
-    #define RX_HI() digitalWrite(PIN_RXEN, HIGH);
-    #define RX_LO() digitalWrite(PIN_RXEN, LOW);
-    
 public:
+    DeviceCYRF6936(const RFPINS_T *pins) : DeviceRF<DeviceCYRF6936>(pins) { }
+
     void initialize();
     int  reset();
     u8   writeReg(u8 reg, u8 data);
@@ -112,7 +103,8 @@ public:
     u8   writePayload_P(const u8 *data, u8 length);
     u8   readPayload(u8 *data, u8 length);
     u8   readRSSI(u32 dodummyread);
-    void findBestChannels(u8 *channels, u8 len, u8 minspace, u8 min, u8 max);
+    void findBestChannels(u8 *channels, u8 len, u8 minspace, u8 min, u8 max,
+                          u16 dwell = 10000, u8 samples = 1, u8 quiet = 0);
     
 // To enable radio transmit after WritePayload you need to turn the radio
 //void PulseCE();
@@ -121,7 +113,6 @@ private:
     u8   strobe(u8 state);
 
 // variables
-
 };
 
 #endif
@@ -14,7 +14,6 @@
 */
 
 
-#include <SPI.h>
 #include "DeviceNRF24L01.h"
 
 /* Instruction Mnemonics */
@@ -31,27 +30,97 @@
 #define REUSE_TX_PL   0xE3
 #define NOP           0xFF
 
+#define CS_HI() deselect();
+#define CS_LO() select();
+#define CE_HI() setPin(mPins->ce, HIGH);
+#define CE_LO() setPin(mPins->ce, LOW);
+
+// power on values of the shadowed registers : 00 - 06, RX_PW_P0, DYNPD, FEATURE
+static const PROGMEM u8 TBL_SHADOW_DEFS[NRF_SHADOW_REGS] = {
+    0x08, 0x3f, 0x03, 0x03, 0x03, 0x02, 0x0f, 0x00, 0x00, 0x00
+};
+
+// index in mShadow, -1 for status and per packet registers
+static s8 getShadowIdx(u8 reg)
+{
+    reg &= REGISTER_MASK;
+    if (reg <= NRF24L01_06_RF_SETUP)
+        return reg;
+    if (reg == NRF24L01_11_RX_PW_P0)
+        return 7;
+    if (reg == NRF24L01_1C_DYNPD)
+        return 8;
+    if (reg == NRF24L01_1D_FEATURE)
+        return 9;
+    return -1;
+}
+
 void DeviceNRF24L01::initialize()
 {
-    pinMode(PIN_IRQ, INPUT);
-    pinMode(PIN_CSN, OUTPUT);
-    pinMode(PIN_CE, OUTPUT);
+    if (mPins->irq != PIN_NONE)
+        pinMode(mPins->irq, INPUT);
+    pinMode(mPins->csn, OUTPUT);
+    pinMode(mPins->ce, OUTPUT);
 
     CS_HI();
     CE_HI();
 
-    SPI.begin();
-    SPI.setBitOrder(MSBFIRST);
-    SPI.setDataMode(SPI_MODE0);
-    SPI.setClockDivider(SPI_CLOCK_DIV2);
+    initSPI();
 
     mRFsetup = 0x0F;
+    mRetrMax = 0;
+    memset(mChanStats, 0, sizeof(mChanStats));
+    memcpy_P(mShadow, TBL_SHADOW_DEFS, sizeof(mShadow));
+    memset(mTxAddr, 0xe7, sizeof(mTxAddr));
+    memset(mRxAddr, 0xe7, sizeof(mRxAddr));
+}
+
+void DeviceNRF24L01::saveAddr(u8 reg, const u8 *data, u8 length, bool pgm)
+{
+    u8 *addr;
+
+    reg &= REGISTER_MASK;
+    if (reg == NRF24L01_10_TX_ADDR)
+        addr = mTxAddr;
+    else if (reg == NRF24L01_0A_RX_ADDR_P0)
+        addr = mRxAddr;
+    else
+        return;
+
+    if (length > NRF_ADDR_SIZE)
+        length = NRF_ADDR_SIZE;
+    if (pgm)
+        memcpy_P(addr, data, length);
+    else
+        memcpy(addr, data, length);
+}
+
+// the chip is shared with another protocol which may have changed everything
+void DeviceNRF24L01::restore(void)
+{
+    CE_LO();
+    for (u8 i = NRF24L01_01_EN_AA; i <= NRF24L01_06_RF_SETUP; i++)
+        writeReg(i, mShadow[i]);
+    writeReg(NRF24L01_11_RX_PW_P0, mShadow[7]);
+    writeReg(NRF24L01_1D_FEATURE, mShadow[9]);
+    writeReg(NRF24L01_1C_DYNPD, mShadow[8]);
+    writeRegMulti(NRF24L01_10_TX_ADDR, mTxAddr, NRF_ADDR_SIZE);
+    writeRegMulti(NRF24L01_0A_RX_ADDR_P0, mRxAddr, NRF_ADDR_SIZE);
+    writeReg(NRF24L01_07_STATUS, 0x70);
+    flushTx();
+    flushRx();
+    writeReg(NRF24L01_00_CONFIG, mShadow[0]);
+    CE_HI();
 }
 
-#define PROTOSPI_xfer   SPI.transfer
+#define PROTOSPI_xfer   xfer
 
 u8 DeviceNRF24L01::writeReg(u8 reg, u8 data)
 {
+    s8 idx = getShadowIdx(reg);
+
+    if (idx >= 0)
+        mShadow[idx] = data;
     CS_LO();
     u8 res = PROTOSPI_xfer(W_REGISTER | (REGISTER_MASK & reg));
     PROTOSPI_xfer(data);
@@ -61,6 +130,7 @@ u8 DeviceNRF24L01::writeReg(u8 reg, u8 data)
 
 u8 DeviceNRF24L01::writeRegMulti(u8 reg, const u8 *data, u8 length)
 {
+    saveAddr(reg, data, length, false);
     CS_LO();
     u8 res = PROTOSPI_xfer(W_REGISTER | ( REGISTER_MASK & reg));
     for (u8 i = 0; i < length; i++) {
@@ -72,6 +142,7 @@ u8 DeviceNRF24L01::writeRegMulti(u8 reg, const u8 *data, u8 length)
 
 u8 DeviceNRF24L01::writeRegMulti_P(u8 reg, const u8 *data, u8 length)
 {
+    saveAddr(reg, data, length, true);
     CS_LO();
     u8 res = PROTOSPI_xfer(W_REGISTER | ( REGISTER_MASK & reg));
     for (u8 i = 0; i < length; i++) {
@@ -253,6 +324,39 @@ void DeviceNRF24L01::setTxRxMode(enum TXRX_State mode)
     }
 }
 
+// CE high keeps the chip in TX mode and sends whatever is in the FIFO (standby-II when empty).
+// a pulse of more than 10us sends one packet, then the chip falls back to standby-I.
+void DeviceNRF24L01::startTx(bool pulse)
+{
+    CE_HI();
+    if (pulse) {
+        delayMicroseconds(15);
+        CE_LO();
+    }
+}
+
+bool DeviceNRF24L01::isTxBusy(void)
+{
+    return !(readReg(NRF24L01_17_FIFO_STATUS) & (1 << NRF24L01_17_TX_EMPTY));
+}
+
+// clearing PWR_UP aborts a packet on the air, wait for the FIFO to drain first
+void DeviceNRF24L01::powerDown(void)
+{
+    u8 i;
+
+    for (i = 0; i < 10 && isTxBusy(); i++)
+        delayMicroseconds(100);
+    CE_LO();
+    writeReg(NRF24L01_00_CONFIG, readReg(NRF24L01_00_CONFIG) & ~(1 << NRF24L01_00_PWR_UP));
+}
+
+// needs Tpd2stby (1.5ms max) before the next packet
+void DeviceNRF24L01::powerUp(void)
+{
+    writeReg(NRF24L01_00_CONFIG, readReg(NRF24L01_00_CONFIG) | (1 << NRF24L01_00_PWR_UP));
+}
+
 int DeviceNRF24L01::reset()
 {
     flushTx();
@@ -263,3 +367,66 @@ int DeviceNRF24L01::reset()
     return (status1 == status2 && (status1 & 0x0f) == 0x0e);
 }
 
+#define RETR_MIN_COUNT      1
+#define RETR_CLEAN_PACKETS  50      // clean packets before one retransmit less
+
+void DeviceNRF24L01::setRetransmit(u8 delay, u8 count, u8 max)
+{
+    mRetrDelay = delay & 0x0f;
+    mRetrCnt   = count & 0x0f;
+    mRetrMax   = max & 0x0f;
+    mRetrClean = 0;
+    writeReg(NRF24L01_04_SETUP_RETR, (mRetrDelay << 4) | mRetrCnt);
+}
+
+// channel entry, the least used one is recycled when all are taken
+NRF_CHAN_STAT_T *DeviceNRF24L01::getChanStat(u8 rfChan)
+{
+    NRF_CHAN_STAT_T *stat = mChanStats;
+
+    for (u8 i = 0; i < NRF_MAX_STAT_CHANNELS; i++) {
+        if (mChanStats[i].rfChan == rfChan && mChanStats[i].sent)
+            return &mChanStats[i];
+        if (mChanStats[i].sent < stat->sent)
+            stat = &mChanStats[i];
+    }
+    memset(stat, 0, sizeof(NRF_CHAN_STAT_T));
+    stat->rfChan = rfChan;
+    return stat;
+}
+
+// more retransmits as soon as packets get lost, one less after a run of clean packets
+void DeviceNRF24L01::updateLinkStats(u8 rfChan, bool acked)
+{
+    NRF_CHAN_STAT_T *stat = getChanStat(rfChan);
+    u8 arc = readReg(NRF24L01_08_OBSERVE_TX) & 0x0f;
+    u8 cnt = mRetrCnt;
+
+    stat->sent++;
+    stat->retries += arc;
+    if (!acked)
+        stat->lost++;
+
+    if (!mRetrMax)
+        return;
+
+    if (!acked || arc >= mRetrCnt) {
+        mRetrClean = 0;
+        if (cnt < mRetrMax)
+            cnt++;
+    } else if (arc == 0 && ++mRetrClean >= RETR_CLEAN_PACKETS) {
+        mRetrClean = 0;
+        if (cnt > RETR_MIN_COUNT)
+            cnt--;
+    }
+    if (cnt != mRetrCnt) {
+        mRetrCnt = cnt;
+        writeReg(NRF24L01_04_SETUP_RETR, (mRetrDelay << 4) | mRetrCnt);
+    }
+}
+
+u8 DeviceNRF24L01::getLinkStats(u8 *data)
+{
+    memcpy(data, mChanStats, sizeof(mChanStats));
+    return sizeof(mChanStats);
+}
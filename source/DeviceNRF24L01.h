@@ -17,7 +17,8 @@
 #ifndef _DEVICE_NRF24L01_H_
 #define _DEVICE_NRF24L01_H_
 
-#include "Common.h"
+#include "common.h"
+#include "DeviceRF.h"
 #include <Arduino.h>
 #include <avr/pgmspace.h>
 
@@ -81,6 +82,8 @@ enum {
     NRF24L01_07_TX_DS       = 5,
     NRF24L01_07_MAX_RT      = 4,
 
+    NRF24L01_17_TX_EMPTY    = 4,
+
     NRF2401_1D_EN_DYN_ACK   = 0,
     NRF2401_1D_EN_ACK_PAY   = 1,
     NRF2401_1D_EN_DPL       = 2,
@@ -94,19 +97,25 @@ enum {
     NRF24L01_BR_RSVD
 };
 
-
-class DeviceNRF24L01
+#define NRF_MAX_STAT_CHANNELS   4
+#define NRF_SHADOW_REGS         10
+#define NRF_ADDR_SIZE           5
+
+// delivery of auto acknowledged packets on one RF channel.
+// sent as is by INFO_LINK_STATS, packed so the host build has the AVR layout
+typedef struct {
+    u8   rfChan;
+    u16  sent;
+    u16  lost;              // MAX_RT, all retransmits failed
+    u16  retries;           // retransmits of all packets
+} __attribute__((packed)) NRF_CHAN_STAT_T;
+ctassert(sizeof(NRF_CHAN_STAT_T) == 7, nrf_chan_stat_size);
+
+class DeviceNRF24L01 : public DeviceRF<DeviceNRF24L01>
 {
-    #define PIN_IRQ       2
-    #define PIN_CSN       8
-    #define PIN_CE        7
-
-    #define CS_HI() digitalWrite(PIN_CSN, HIGH);
-    #define CS_LO() digitalWrite(PIN_CSN, LOW);
-    #define CE_HI() digitalWrite(PIN_CE, HIGH);
-    #define CE_LO() digitalWrite(PIN_CE, LOW);
-
 public:
+    DeviceNRF24L01(const RFPINS_T *pins) : DeviceRF<DeviceNRF24L01>(pins) { }
+
     void initialize();
     int  reset();
     u8   writeReg(u8 reg, u8 data);
@@ -125,14 +134,37 @@ public:
     u8   setRFPower(u8 power);
     void setTxRxMode(enum TXRX_State);
 
-// To enable radio transmit after WritePayload you need to turn the radio
-//void PulseCE();
+    // pulse : send one packet and return to standby-I, otherwise CE stays high
+    void startTx(bool pulse);
+    bool isTxBusy(void);
+    void powerDown(void);
+    void powerUp(void);
+
+    // auto retransmit : delay in 250us steps - 1, count is adapted up to max by updateLinkStats.
+    // max 0 keeps the count fixed
+    void setRetransmit(u8 delay, u8 count, u8 max);
+    // call once per packet after TX_DS or MAX_RT, reads OBSERVE_TX
+    void updateLinkStats(u8 rfChan, bool acked);
+    u8   getLinkStats(u8 *data);
+
+    // rewrites the configuration written through this object, for a chip shared by two protocols
+    void restore(void);
 
 private:
     u8   strobe(u8 state);
+    void saveAddr(u8 reg, const u8 *data, u8 length, bool pgm);
+    NRF_CHAN_STAT_T *getChanStat(u8 rfChan);
 
 // variables
     u8   mRFsetup;
+    u8   mRetrDelay;
+    u8   mRetrCnt;
+    u8   mRetrMax;
+    u8   mRetrClean;        // packets acked without retransmit in a row
+    NRF_CHAN_STAT_T mChanStats[NRF_MAX_STAT_CHANNELS];
+    u8   mShadow[NRF_SHADOW_REGS];
+    u8   mTxAddr[NRF_ADDR_SIZE];
+    u8   mRxAddr[NRF_ADDR_SIZE];
 };
 
 #endif
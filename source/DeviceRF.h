@@ -0,0 +1,68 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _DEVICE_RF_H_
+#define _DEVICE_RF_H_
+
+#include "common.h"
+#include <Arduino.h>
+#include <SPI.h>
+#ifdef RF_MOCK
+#include "RadioMock.h"
+#endif
+
+// common part of radio devices, D is the device class (CRTP).
+// every device provides the register API checked in the constructor : initialize, reset,
+// writeReg, writeRegMulti, readReg, setRFPower and setTxRxMode. protocols keep their concrete
+// device so calls are bound at compile time, there is no vtable. the wiring and the bus
+// access below are inlined, with RF_MOCK the bus goes to RadioMock so protocols can run on
+// a host without a radio.
+template <class D> class DeviceRF
+{
+public:
+    DeviceRF(const RFPINS_T *pins) {
+        mPins = pins;
+        // no code, a device missing a call or with another signature does not compile
+        (void)static_cast<void (D::*)(void)>(&D::initialize);
+        (void)static_cast<int  (D::*)(void)>(&D::reset);
+        (void)static_cast<u8   (D::*)(u8, u8)>(&D::writeReg);
+        (void)static_cast<u8   (D::*)(u8, const u8 *, u8)>(&D::writeRegMulti);
+        (void)static_cast<u8   (D::*)(u8)>(&D::readReg);
+        (void)static_cast<u8   (D::*)(u8)>(&D::setRFPower);
+        (void)static_cast<void (D::*)(enum TXRX_State)>(&D::setTxRxMode);
+    }
+
+protected:
+#ifdef RF_MOCK
+    void initSPI(void)              { }
+    void select(void)               { RadioMock::select(mPins->csn);   }
+    void deselect(void)             { RadioMock::deselect(mPins->csn); }
+    u8   xfer(u8 data)              { return RadioMock::xfer(data);    }
+    void setPin(u8 pin, u8 val)     { if (pin != PIN_NONE) RadioMock::setPin(pin, val); }
+#else
+    void initSPI(void) {
+        SPI.begin();
+        SPI.setBitOrder(MSBFIRST);
+        SPI.setDataMode(SPI_MODE0);
+        SPI.setClockDivider(SPI_CLOCK_DIV2);
+    }
+    void select(void)               { digitalWrite(mPins->csn, LOW);  }
+    void deselect(void)             { digitalWrite(mPins->csn, HIGH); }
+    u8   xfer(u8 data)              { return SPI.transfer(data);      }
+    void setPin(u8 pin, u8 val)     { if (pin != PIN_NONE) digitalWrite(pin, val); }
+#endif
+
+    const RFPINS_T *mPins;
+};
+
+#endif
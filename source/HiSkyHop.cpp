@@ -0,0 +1,62 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is derived from deviationTx project for Arduino.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#include "HiSkyHop.h"
+
+#define BAND_MAX_CHANNELS   8
+
+// channels 2..26, 27..50, 51..74
+static u8 getBand(u8 ch)
+{
+    return (ch <= 26) ? 0 : ((ch <= 50) ? 1 : 2);
+}
+
+u16 HiSkyHop::build(u32 seed, u8 *chans)
+{
+    u8  used[10];       // bit map of channels 0..79
+    u8  bands[3];
+    u8  idx = 0;
+    u8  ch;
+    u16 draws;
+    u32 rnd = seed;
+
+    memset(used, 0, sizeof(used));
+    memset(bands, 0, sizeof(bands));
+
+    for (draws = 0; idx < HISKY_HOP_CHANNELS && draws < HISKY_HOP_MAX_DRAWS; draws++) {
+        rnd = rnd * 0x0019660D + 0x3C6EF35F; // Randomization
+
+        // 73 is prime, so channels 76..77 are unused
+        ch = ((rnd >> 8) % 73) + 2;
+        // Keep the distance 2 between the channels - either odd or even
+        if (((ch ^ seed) & 0x01) == 0)
+            continue;
+        // not duplicate and spread uniformly
+        if ((used[ch >> 3] & (1 << (ch & 0x07))) || bands[getBand(ch)] >= BAND_MAX_CHANNELS)
+            continue;
+        used[ch >> 3] |= (1 << (ch & 0x07));
+        bands[getBand(ch)]++;
+        chans[idx++] = ch;
+    }
+
+    // out of draws, 36 channels of the parity are enough for 20 with 8 per band
+    for (ch = (seed & 0x01) ? 2 : 3; idx < HISKY_HOP_CHANNELS; ch += 2) {
+        if ((used[ch >> 3] & (1 << (ch & 0x07))) || bands[getBand(ch)] >= BAND_MAX_CHANNELS)
+            continue;
+        bands[getBand(ch)]++;
+        chans[idx++] = ch;
+    }
+    return draws;
+}
@@ -0,0 +1,34 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is derived from deviationTx project for Arduino.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _HISKY_HOP_H_
+#define _HISKY_HOP_H_
+
+#include "common.h"
+
+#define HISKY_HOP_CHANNELS      20
+#define HISKY_HOP_MAX_DRAWS    256
+
+// HiSky hopping table, no Arduino dependency so tools/hisky_hop can build it on host.
+// same table as deviation as long as HISKY_HOP_MAX_DRAWS random draws are enough
+// (max 164 over 20M seeds), the rest is filled in channel order.
+class HiSkyHop
+{
+public:
+    // returns number of random draws used
+    static u16 build(u32 seed, u8 *chans);
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// For Arduino 1.0 and earlier
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <avr/pgmspace.h>
+#include "ProtocolRegistry.h"
+#include "RFProtocolSyma.h"
+#include "RFProtocolYD717.h"
+#include "RFProtocolV2x2.h"
+#include "RFProtocolHiSky.h"
+#include "RFProtocolCFlie.h"
+#include "RFProtocolDevo.h"
+#include "RFProtocolHubsan.h"
+#include "RFProtocolFlysky.h"
+
+#define MAX2(a, b)  ((a) > (b) ? (a) : (b))
+
+// restoring the nRF24L01 configuration of the other protocol
+#define RADIO_SWITCH_uS     150
+
+// every protocol in the table must be listed here
+#define ARENA_SIZE  MAX2(MAX2(MAX2(sizeof(RFProtocolV2x2),   sizeof(RFProtocolHiSky)), \
+                              MAX2(sizeof(RFProtocolYD717),  sizeof(RFProtocolSyma))),  \
+                         MAX2(MAX2(sizeof(RFProtocolCFlie),  sizeof(RFProtocolFlysky)), \
+                              MAX2(sizeof(RFProtocolHubsan), sizeof(RFProtocolDevo))))
+
+// one arena per slot, a protocol object is constructed in place
+static union {
+    u8    buf[ARENA_SIZE];
+    u32   align;
+    void *ptr;
+} mArenas[MAX_PROTO_SLOT];
+
+typedef RFProtocol *(*PROTO_FACTORY_T)(u32 id, void *mem);
+
+typedef struct {
+    PROTO_FACTORY_T factory;
+    PROTO_INFO_T    info;
+    u8              optMax;     // options are values up to this one, 0 : options are bits
+} PROTO_DESC_T;
+
+template <class T> static RFProtocol *newProtocol(u32 id, void *mem)
+{
+    ctassert(sizeof(T) <= ARENA_SIZE, protocol_not_in_arena_size);
+    return new(mem) T(id);
+}
+
+static const PROGMEM PROTO_DESC_T TBL_PROTOCOLS[] = {
+    // hold : from the state call to the end of the packet on air. protocols waiting for
+    // an ack in the next state call or using a receive window can not share the chip
+    // factory                            module                    protocol                               period hold ch  options  name       optMax
+    { newProtocol<RFProtocolV2x2>,   { RFProtocol::TX_NRF24L01, RFProtocol::PROTO_NRF24L01_V2x2,   4000,    0, 10, 0x07, "V2x2"   }, 0 },
+    { newProtocol<RFProtocolHiSky>,  { RFProtocol::TX_NRF24L01, RFProtocol::PROTO_NRF24L01_HISKY,  1000,  300,  8, 0x01, "HiSky"  }, 0 },
+    { newProtocol<RFProtocolYD717>,  { RFProtocol::TX_NRF24L01, RFProtocol::PROTO_NRF24L01_YD717,  8000,    0,  9, 0x07, "YD717"  }, 4 },    // up to Syma X4
+    { newProtocol<RFProtocolSyma>,   { RFProtocol::TX_NRF24L01, RFProtocol::PROTO_NRF24L01_SYMAX,  4000,  800,  8, 0x01, "SymaX"  }, 0 },
+    { newProtocol<RFProtocolCFlie>,  { RFProtocol::TX_NRF24L01, RFProtocol::PROTO_NRF24L01_CFLIE, 10000,    0,  4, 0x00, "CFlie"  }, 0 },
+    { newProtocol<RFProtocolFlysky>, { RFProtocol::TX_A7105,    RFProtocol::PROTO_A7105_FLYSKY,    1460,    0, 12, 0x03, "Flysky" }, 0 },
+    { newProtocol<RFProtocolHubsan>, { RFProtocol::TX_A7105,    RFProtocol::PROTO_A7105_HUBSAN,   10000,    0,  7, 0xff, "Hubsan" }, 0 },
+    { newProtocol<RFProtocolDevo>,   { RFProtocol::TX_CYRF6936, RFProtocol::PROTO_CYRF6936_DEVO,   1200,    0, 12, 0xc0, "Devo"   }, 0 },
+};
+
+u8 ProtocolRegistry::getCount(void)
+{
+    return sizeof(TBL_PROTOCOLS) / sizeof(PROTO_DESC_T);
+}
+
+bool ProtocolRegistry::getInfo(u8 idx, PROTO_INFO_T *info)
+{
+    if (idx >= getCount())
+        return false;
+    memcpy_P(info, &TBL_PROTOCOLS[idx].info, sizeof(PROTO_INFO_T));
+    return true;
+}
+
+s8 ProtocolRegistry::find(u32 id)
+{
+    u8 module = RFProtocol::getModule(id);
+    u8 proto  = RFProtocol::getProtocol(id);
+
+    for (u8 i = 0; i < getCount(); i++) {
+        if (pgm_read_byte(&TBL_PROTOCOLS[i].info.module) == module &&
+            pgm_read_byte(&TBL_PROTOCOLS[i].info.proto) == proto)
+            return i;
+    }
+    return -1;
+}
+
+u8 ProtocolRegistry::getMaxChannels(u32 id)
+{
+    s8 idx = find(id);
+
+    if (idx < 0)
+        return 0;
+    return pgm_read_byte(&TBL_PROTOCOLS[idx].info.channels);
+}
+
+u16 ProtocolRegistry::getArenaSize(void)
+{
+    return ARENA_SIZE;
+}
+
+// a state call is put off by the hold time of the other protocol and a switch at most
+u16 ProtocolRegistry::getShareTime(u32 id1, u32 id2)
+{
+    s8  idx1 = find(id1);
+    s8  idx2 = find(id2);
+    u16 hold1, hold2, period1, period2;
+
+    if (idx1 < 0 || idx2 < 0)
+        return 0;
+
+    hold1  = pgm_read_word(&TBL_PROTOCOLS[idx1].info.hold);
+    hold2  = pgm_read_word(&TBL_PROTOCOLS[idx2].info.hold);
+    period1 = pgm_read_word(&TBL_PROTOCOLS[idx1].info.period);
+    period2 = pgm_read_word(&TBL_PROTOCOLS[idx2].info.period);
+    if (!hold1 || !hold2 || (u32)hold1 + hold2 + 2 * RADIO_SWITCH_uS > (period1 < period2 ? period1 : period2))
+        return 0;
+    return hold1;
+}
+
+RFProtocol *ProtocolRegistry::create(u32 id, u8 slot)
+{
+    s8 idx = find(id);
+    PROTO_FACTORY_T factory;
+    RFProtocol *proto;
+    u8 opt, optMax;
+
+    if (idx < 0 || slot >= MAX_PROTO_SLOT)
+        return NULL;
+    opt    = RFProtocol::getProtocolOpt(id);
+    optMax = pgm_read_byte(&TBL_PROTOCOLS[idx].optMax);
+    if (optMax ? opt > optMax : (opt & ~pgm_read_byte(&TBL_PROTOCOLS[idx].info.options)))
+        return NULL;
+
+    memcpy_P(&factory, &TBL_PROTOCOLS[idx].factory, sizeof(factory));
+    proto = factory(id, mArenas[slot].buf);
+    proto->setChannelCount(pgm_read_byte(&TBL_PROTOCOLS[idx].info.channels));
+    return proto;
+}
+
+void ProtocolRegistry::destroy(RFProtocol *proto)
+{
+    if (proto)
+        proto->~RFProtocol();
+}
@@ -0,0 +1,58 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _PROTOCOL_REGISTRY_H_
+#define _PROTOCOL_REGISTRY_H_
+
+#include "common.h"
+#include "RFProtocol.h"
+
+#define PROTO_NAME_LEN  8
+
+// two protocols can run at the same time on different modules, selected by bit 7 of command
+#define MAX_PROTO_SLOT  2
+
+// public part of a descriptor, sent as is by CMD_GET_PROTOCOL
+typedef struct {
+    u8   module;                // RFProtocol::TX_xxx
+    u8   proto;                 // RFProtocol::PROTO_xxx
+    u16  period;                // nominal packet period in us
+    u16  hold;                  // radio time per period for TDM in us, 0 : can not share the chip
+    u8   channels;              // controls used
+    u8   options;               // option bits the protocol understands
+    char name[PROTO_NAME_LEN];  // not terminated when all 8 chars are used
+} PROTO_INFO_T;
+
+// protocols built in the firmware, the table lives in PROGMEM.
+// objects are not allocated from heap, every slot has a static arena
+// as big as the largest protocol.
+class ProtocolRegistry
+{
+public:
+    static u8   getCount(void);
+    static bool getInfo(u8 idx, PROTO_INFO_T *info);
+    static s8   find(u32 id);
+    static u8   getMaxChannels(u32 id);     // 0 for unknown protocol
+    static u16  getArenaSize(void);
+
+    // TDM admission : both run on one chip only when their hold times and the switches
+    // fit within the shorter period. 0 if they can not share, the hold time of id1 otherwise
+    static u16  getShareTime(u32 id1, u32 id2);
+
+    // constructs in the arena of slot with the maximum channel count, the previous object must be destroyed.
+    // NULL for unknown protocol or unsupported option bits
+    static RFProtocol *create(u32 id, u8 slot);
+    static void destroy(RFProtocol *proto);
+};
+
+#endif
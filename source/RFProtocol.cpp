@@ -21,30 +21,66 @@
 #endif
 
 #include "RFProtocol.h"
+#include "Storage.h"
 #include "utils.h"
 
+#define WAKEUP_uS       1500        // nRF24L01 Tpd2stby
+#define MIN_SLEEP_uS    1000
+
+RFProtocol *RFProtocol::mRadioOwner[MAX_MODULE];
+u32 RFProtocol::mRadioFreeUs[MAX_MODULE];
 
 void RFProtocol::initVars(void)
 {
     memset(mBufControls, 0, sizeof(mBufControls));
     mBufControls[CH_THROTTLE] = CHAN_MIN_VALUE;
+    mDirty = (1 << MAX_CHANNEL) - 1;
 
     mTmrState = -1;
+    mTmrWake  = 0;
     mTXPower  = TXPOWER_10mW;
+    mPowerMode = POWER_ALWAYS_ON;
+    mResume   = 0;
+    mBindPendSize = 0;
+    mFailsafePend = 0;
+    mConID    = 0;
+    mFailsafeMask = 0;
+    memset(mFailsafe, 0, sizeof(mFailsafe));
+    mShareUs  = 0;
+    mChanCnt  = MAX_CHANNEL;
 }
 
+// default wiring of UniConTX board
+static const PROGMEM RFPINS_T TBL_DEF_PINS[] = {
+    //  csn, ce/txen,     rxen,      irq
+    {     8,       7, PIN_NONE,        2 },     // TX_NRF24L01
+    {    10,       7,        6, PIN_NONE },     // TX_A7105
+    {     9, PIN_NONE, PIN_NONE,       2 },     // TX_CYRF6936
+};
+
 RFProtocol::RFProtocol(u32 id)
 {
+    u8 module = getModule(id);
+
     mProtoID = id;
+    if (module >= sizeof(TBL_DEF_PINS) / sizeof(RFPINS_T))
+        module = TX_NRF24L01;
+    memcpy_P(&mPins, &TBL_DEF_PINS[module], sizeof(mPins));
     initVars();
 }
 
 RFProtocol::~RFProtocol()
 {
+    if (getModule() < MAX_MODULE && mRadioOwner[getModule()] == this)
+        mRadioOwner[getModule()] = NULL;
 }
 
 void RFProtocol::loop(void)
 {
+    if (mBindPendSize)
+        writeBind();
+    if (mFailsafePend)
+        writeFailsafe();
     update();
 }
 
@@ -53,10 +89,21 @@ int RFProtocol::init(void)
     return 0;
 }
 
+// the chip is reset by the protocol, the other one has to configure it again
 int RFProtocol::close(void)
 {
+    // queued records are posted before the protocol goes away, Storage keeps its copy
+    while (mBindPendSize || mFailsafePend) {
+        Storage::flush();
+        if (mBindPendSize)
+            writeBind();
+        else
+            writeFailsafe();
+    }
     if (mTmrState > 0)
         stop(mTmrState);
+    if (mShareUs)
+        mRadioOwner[getModule()] = NULL;
     return 0;
 }
 
@@ -86,6 +133,181 @@ void RFProtocol::clearRFPowerUpdated(void)
     mTXPower &= 0x7f;
 }
 
+// only nRF24L01 protocols switch the radio between packets
+int RFProtocol::setPowerMode(u8 mode)
+{
+    if (mode > POWER_DOWN || (mode != POWER_ALWAYS_ON && (getModule() != TX_NRF24L01 || mShareUs)))
+        return -1;
+    mPowerMode = mode;
+    return 0;
+}
+
+// a shared chip must stay powered for the other protocol.
+// when sharing ends the chip may hold the configuration of the other protocol
+void RFProtocol::setRadioShare(u16 hold)
+{
+    if (getModule() >= MAX_MODULE)
+        return;
+    if (!hold && mShareUs)
+        mRadioOwner[getModule()] = NULL;
+    mShareUs = hold;
+    if (hold)
+        mPowerMode = POWER_ALWAYS_ON;
+}
+
+// the chip belongs to the protocol which ran last until its hold time is over.
+// false when the state call is put off to wait for the chip
+bool RFProtocol::claimRadio(void)
+{
+    u8  module = getModule();
+    s32 wait;
+
+    if (mRadioOwner[module] == this)
+        return true;
+
+    wait = (s32)(mRadioFreeUs[module] - micros());
+    if (mRadioOwner[module] && wait > 0) {
+        mTmrState = after(wait);
+        return false;
+    }
+    mRadioOwner[module] = this;
+    restoreRadio();
+    return true;
+}
+
+int RFProtocol::setChannelCount(u8 cnt)
+{
+    if (cnt == 0 || cnt > MAX_CHANNEL)
+        return -1;
+    mChanCnt = cnt;
+    return 0;
+}
+
+int RFProtocol::startBind(void)
+{
+    mResume = 0;
+    close();
+    return init();
+}
+
+// record : protocol id(4) + protocol data, keyed by controller id
+bool RFProtocol::loadRecord(u8 slot, void *data, u8 size)
+{
+    u8  rec[4 + MAX_RECORD_DATA];
+
+    if (size > MAX_RECORD_DATA || 4 + size > Storage::getSlotSize(slot) || getModule() > TX_CYRF6936)
+        return false;
+    if (Storage::read(slot, mConID, rec, 4 + size) < 0)
+        return false;
+    if (*(u32*)rec != mProtoID)
+        return false;
+    memcpy(data, rec + 4, size);
+    return true;
+}
+
+// a record that does not fit is dropped and reported as posted
+bool RFProtocol::postRecord(u8 slot, const void *data, u8 size)
+{
+    u8  rec[4 + MAX_RECORD_DATA];
+
+    if (size > MAX_RECORD_DATA || 4 + size > Storage::getSlotSize(slot) || getModule() > TX_CYRF6936)
+        return true;
+    *(u32*)rec = mProtoID;
+    memcpy(rec + 4, data, size);
+    return Storage::post(slot, mConID, rec, 4 + size);
+}
+
+bool RFProtocol::loadBind(void *data, u8 size)
+{
+    if (getModule() > TX_CYRF6936)
+        return false;
+    for (u8 i = 0; i < BIND_RECORDS; i++) {
+        if (loadRecord(Storage::SLOT_BIND_NRF24L01 + getModule() * BIND_RECORDS + i, data, size))
+            return true;
+    }
+    return false;
+}
+
+// call once when binding is done, safe from the packet path
+void RFProtocol::saveBind(const void *data, u8 size)
+{
+    if (getModule() > TX_CYRF6936 || 4 + size > Storage::getSlotSize(Storage::SLOT_BIND_NRF24L01))
+        return;
+    memcpy(mBindPend, data, size);
+    mBindPendSize = size;
+}
+
+// replaces the record of this model, else a free one, else the oldest.
+// the record is posted to Storage, the main loop writes it a byte at a time
+void RFProtocol::writeBind(void)
+{
+    u8  base = Storage::SLOT_BIND_NRF24L01 + getModule() * BIND_RECORDS;
+    u8  slot = base;
+    s16 age;
+    s16 oldest = -1;
+    u8  rec[BIND_RECORD_SIZE - 4];
+
+    if (Storage::poll())
+        return;                 // another record is still being written
+
+    for (u8 i = 0; i < BIND_RECORDS; i++) {
+        if (loadRecord(base + i, rec, mBindPendSize)) {
+            slot = base + i;
+            break;
+        }
+        age = Storage::getAge(base + i);
+        if (age < 0)
+            age = 0x7fff;           // erased slots are taken first
+        if (age > oldest) {
+            slot   = base + i;
+            oldest = age;
+        }
+    }
+    if (postRecord(slot, mBindPend, mBindPendSize))
+        mBindPendSize = 0;
+}
+
+void RFProtocol::setFailsafe(u16 mask, const s16 *vals)
+{
+    mFailsafeMask = mask & ((1 << MAX_CHANNEL) - 1);
+    memcpy(mFailsafe, vals, sizeof(mFailsafe));
+}
+
+// record : mask(2) + values(2 * MAX_CHANNEL)
+bool RFProtocol::loadFailsafe(void)
+{
+    u8 rec[2 + sizeof(mFailsafe)];
+
+    if (!loadRecord(Storage::SLOT_FAILSAFE_NRF24L01 + getModule(), rec, sizeof(rec)))
+        return false;
+    setFailsafe(*(u16*)rec, (s16*)(rec + 2));
+    return true;
+}
+
+void RFProtocol::saveFailsafe(void)
+{
+    mFailsafePend = 1;
+}
+
+void RFProtocol::writeFailsafe(void)
+{
+    u8 rec[2 + sizeof(mFailsafe)];
+
+    *(u16*)rec = mFailsafeMask;
+    memcpy(rec + 2, mFailsafe, sizeof(mFailsafe));
+    if (postRecord(Storage::SLOT_FAILSAFE_NRF24L01 + getModule(), rec, sizeof(rec)))
+        mFailsafePend = 0;
+}
+
+// channels without failsafe keep their last value
+void RFProtocol::applyFailsafe(void)
+{
+    for (u8 i = 0; i < MAX_CHANNEL; i++) {
+        if (mFailsafeMask & BV(i))
+            injectControl(i, mFailsafe[i]);
+    }
+}
+
 int RFProtocol::getInfo(s8 id, u8 *data)
 {
     u8 size = 0;
@@ -104,15 +326,55 @@ int RFProtocol::getInfo(s8 id, u8 *data)
     return size;
 }
 
+// IRQ lines are inputs and not used, only output pins can not be shared
+bool RFProtocol::isPinConflict(RFProtocol *proto)
+{
+    const u8 *a = (const u8*)&mPins;
+    const u8 *b = (const u8*)proto->getPins();
+
+    for (u8 i = 0; i < 3; i++) {
+        if (a[i] == PIN_NONE)
+            continue;
+        for (u8 j = 0; j < 3; j++) {
+            if (a[i] == b[j])
+                return true;
+        }
+    }
+    return false;
+}
+
+// output pins only
+bool RFProtocol::isPinUsed(u8 pin)
+{
+    const u8 *a = (const u8*)&mPins;
+
+    for (u8 i = 0; i < 3; i++) {
+        if (a[i] == pin)
+            return true;
+    }
+    return false;
+}
+
 void RFProtocol::injectControl(u8 ch, s16 val)
 {
-    mBufControls[ch] = val;
+    if (mBufControls[ch] != val) {
+        mBufControls[ch] = val;
+        mDirty |= BV(ch);
+    }
 }
 
 void RFProtocol::injectControls(s16 *data, int size)
 {
-    for (int i = 0; i < size; i++)
-        mBufControls[i] = *data++;
+    for (int i = 0; i < size && i < mChanCnt; i++)
+        injectControl(i, *data++);
+}
+
+u16 RFProtocol::fetchDirty(void)
+{
+    u16 dirty = mDirty;
+
+    mDirty = 0;
+    return dirty;
 }
 
 s16 RFProtocol::getControl(u8 ch)
@@ -124,17 +386,41 @@ void RFProtocol::handleTimer(s8 id)
 {
     u16 nextTime;
 
-    if (id == mTmrState) {
-        nextTime = callState();
-        if (nextTime > 0)
-            mTmrState = after(nextTime);
-        else
-            stop(mTmrState);
+    if (id != mTmrState)
+        return;
+
+    if (mTmrWake) {
+        mTmrWake  = 0;
+        wake();
+        mTmrState = after(WAKEUP_uS);
+        return;
+    }
+
+    if (mShareUs && !claimRadio())
+        return;
+
+    nextTime = callState();
+    if (mShareUs)
+        mRadioFreeUs[getModule()] = micros() + mShareUs;
+
+    if (nextTime == 0) {
+        stop(mTmrState);
+    } else if (mPowerMode == POWER_DOWN && nextTime >= WAKEUP_uS + MIN_SLEEP_uS) {
+        // sleep now and wake up early enough to keep the packet timing
+        sleep();
+        mTmrWake  = 1;
+        mTmrState = after(nextTime - WAKEUP_uS);
+    } else {
+        mTmrState = after(nextTime);
     }
 }
 
+// init() has just configured the chip
 void RFProtocol::startState(unsigned long period)
 {
+    if (mShareUs)
+        mRadioOwner[getModule()] = this;
+    mTmrWake  = 0;
     mTmrState = after(period);
 }
 
@@ -143,9 +429,14 @@ static const PROGMEM u8 TBL_ORDERS[4] = {
     RFProtocol::CH_AILERON,  RFProtocol::CH_ELEVATOR, 
     RFProtocol::CH_THROTTLE, RFProtocol::CH_RUDDER };
 
-s16 RFProtocol::getControlByOrder(u8 ch)
+u8 RFProtocol::getControlIdxByOrder(u8 ch)
 {
     if (ch < 4)
         ch = pgm_read_byte(TBL_ORDERS + ch);
-    return mBufControls[ch];
+    return ch;
+}
+
+s16 RFProtocol::getControlByOrder(u8 ch)
+{
+    return mBufControls[getControlIdxByOrder(ch)];
 }
\ No newline at end of file
@@ -16,9 +16,38 @@
 #ifndef _PROTOCOL_H_
 #define _PROTOCOL_H_
 
-#include "Common.h"
+#include "common.h"
 #include "utils.h"
 #include "Timer.h"
+#include "Storage.h"
+
+// TELEMETRY_T.updated bits
+#define TELEM_VOLT          0x01    // volt, rpm
+#define TELEM_TEMP          0x02
+#define TELEM_GPS_LONG      0x04
+#define TELEM_GPS_LAT       0x08
+#define TELEM_GPS_ALT       0x10
+#define TELEM_GPS_SPEED     0x20
+#define TELEM_GPS_TIME      0x40
+#define TELEM_LINK          0x80    // rssi, quality
+
+// telemetry from the receiver, sent as is by CMD_GET_TELEMETRY (AVR layout, little endian)
+typedef struct {
+    s32  longitude;     // 1/1000 arc second, west is negative
+    s32  latitude;      // 1/1000 arc second, south is negative
+    s32  altitude;      // 1/1000 m
+    s32  velocity;      // 1/1000 m/s
+    u32  time;          // year(6) month(4) day(5) hour(5) min(6) sec(6), year from 2000
+    u16  rpm[2];
+    u8   volt[3];       // 1/10 V
+    s8   temp[4];       // degree C
+    u8   rssi;          // raw rssi of the last frame
+    u8   quality;       // % of receive windows with a valid frame
+    u8   updated;       // TELEM_xxx bits changed since the last CMD_GET_TELEMETRY
+} TELEMETRY_T;
+
+// response must fit in 64 bytes serial TX buffer with 6 bytes of framing
+ctassert(sizeof(TELEMETRY_T) + 6 <= 64, telemetry_exceeds_serial_buffer);
 
 class RFProtocol : public Timer
 {
@@ -30,6 +59,7 @@ public:
         TX_NRF24L01,
         TX_A7105,
         TX_CYRF6936,
+        MAX_MODULE
     };
 
     enum {
@@ -72,12 +102,20 @@ public:
         MAX_TRIM
     };
 
+    // radio state between packets
+    enum {
+        POWER_ALWAYS_ON,        // stays in TX
+        POWER_STANDBY,          // standby between packets
+        POWER_DOWN,             // power down between packets, wakes up WAKEUP_uS before next packet
+    };
+
     enum {
         INFO_STATE,
         INFO_CHANNEL,
         INFO_PACKET_CTR,
         INFO_ID,
         INFO_RF_POWER,
+        INFO_LINK_STATS,        // NRF_CHAN_STAT_T[NRF_MAX_STAT_CHANNELS] of ack capable nRF24L01 protocols
     };
 
     // utility functions
@@ -90,6 +128,11 @@ public:
     RFProtocol(u32 id);
     virtual ~RFProtocol();
 
+    // constructed in place only, see ProtocolRegistry
+    static void *operator new(size_t size, void *mem)   { return mem; }
+    static void operator delete(void *mem, void *place) { }
+    static void operator delete(void *mem)              { }
+
     u32  getProtoID(void)           { return mProtoID; }
     u8   getModule(void)            { return (mProtoID >> 16) & 0xff; }
     u8   getProtocol(void)          { return (mProtoID >> 8) & 0xff;  }
@@ -97,15 +140,49 @@ public:
     void setControllerID(u32 id)    { mConID = id;     }
     u32  getControllerID()          { return mConID;   }
 
+    // pins must be set before init()
+    void setPins(const RFPINS_T *pins)  { mPins = *pins; }
+    const RFPINS_T *getPins(void)       { return &mPins; }
+    bool isPinConflict(RFProtocol *proto);
+    bool isPinUsed(u8 pin);
+
     void injectControl(u8 ch, s16 val);
     void injectControls(s16 *data, int size);
     s16  getControl(u8 ch);         // TREA order
     s16  getControlByOrder(u8 ch);  // AETR order : deviation order
+    static u8 getControlIdxByOrder(u8 ch);
+
+    // channels sent to the model, controls above are not taken. the registry sets the maximum
+    u8   getChannelCount(void)      { return mChanCnt; }
+
+    // bit mask of controls changed since the last call, cleared by the call
+    u16  fetchDirty(void);
+
+    // start with the bind identity saved in EEPROM instead of binding, set before init()
+    void setResume(bool resume)     { mResume = resume; }
+    bool isResume(void)             { return mResume; }
+
+    // failsafe : values sent when the host is lost, mask bit per channel (TREA order).
+    // saveFailsafe queues the EEPROM record, loop() writes it
+    void setFailsafe(u16 mask, const s16 *vals);
+    u16  getFailsafeMask(void)      { return mFailsafeMask; }
+    s16  getFailsafe(u8 ch)         { return mFailsafe[ch]; }
+    bool loadFailsafe(void);
+    void saveFailsafe(void);
+    void applyFailsafe(void);
+
+    // TDM : two protocols on one chip take turns, a protocol keeps the chip for hold us
+    // after every state call. 0 for a chip of its own, the caller then calls restoreRadio()
+    // if the protocol is running
+    void setRadioShare(u16 hold);
+    bool isRadioShared(void)        { return mShareUs != 0; }
 
     // power
     u8   getRFPower(void);
     bool isRFPowerUpdated(void);
     void clearRFPowerUpdated(void);
+    int  setPowerMode(u8 mode);
+    u8   getPowerMode(void)         { return mPowerMode; }
 
 
     void startState(unsigned long period);
@@ -122,15 +199,59 @@ public:
     virtual int  setRFPower(u8 power);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void) = 0;
+    virtual void sleep(void)        { }
+    virtual void wake(void)         { }
+    virtual void restoreRadio(void) { }     // re-applies the radio configuration for TDM
+    virtual TELEMETRY_T *getTelemetry(void) { return NULL; }
+    virtual int  setChannelCount(u8 cnt);
+
+    // binding : start restarts with a full bind, stop ends it at the next packet.
+    // stop returns -1 when the protocol has to wait for the receiver
+    virtual int  startBind(void);
+    virtual int  stopBind(void)         { return 0; }
+    virtual u8   getBindProgress(void)  { return 100; }    // % done, 100 when bound
+
+protected:
+    #define MAX_RECORD_DATA 26
+
+    // EEPROM record of this protocol and controller ID in an absolute storage slot.
+    // postRecord hands it to Storage::post, false while another record is being written
+    bool loadRecord(u8 slot, void *data, u8 size);
+    bool postRecord(u8 slot, const void *data, u8 size);
+
+    // bind identity of this protocol and controller ID, BIND_RECORDS models per module.
+    // saveBind only queues the record, loop() writes it outside the packet path
+    bool loadBind(void *data, u8 size);
+    void saveBind(const void *data, u8 size);
+
+    static u8 calcBindProgress(u16 ctr, u16 max)   { return 100 - (u32)ctr * 100 / max; }
 
 private:
     void initVars();
+    bool claimRadio(void);
+    void writeBind(void);
+    void writeFailsafe(void);
+
+    static RFProtocol *mRadioOwner[MAX_MODULE];
+    static u32 mRadioFreeUs[MAX_MODULE];
 
     u32  mProtoID;
     u32  mConID;
+    RFPINS_T mPins;
     s16  mBufControls[MAX_CHANNEL];
+    u16  mDirty;
+    s16  mFailsafe[MAX_CHANNEL];
+    u16  mFailsafeMask;
+    u16  mShareUs;
+    u8   mChanCnt;
     s8   mTmrState;
+    u8   mTmrWake;
     u8   mTXPower;
+    u8   mPowerMode;
+    u8   mResume;
+    u8   mBindPend[BIND_RECORD_SIZE - 4];
+    u8   mBindPendSize;                     // queued bind record, 0 when none
+    u8   mFailsafePend;                     // failsafe record to be written
 };
 
 #endif
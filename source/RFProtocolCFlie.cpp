@@ -15,6 +15,7 @@
 
 #include <SPI.h>
 #include "RFProtocolCFlie.h"
+#include "ChanScale.h"
 #include "utils.h"
 
 
@@ -77,6 +78,7 @@ void RFProtocolCFlie::sendSearchPacket(void)
     }
     setRateAndCh(mDataRate, mCurRFChan);
     mDev.writePayload(&buf, sizeof(buf));
+    mDev.startTx(getPowerMode() != POWER_ALWAYS_ON);
     ++mPacketCtr;
 }
 
@@ -84,21 +86,45 @@ void RFProtocolCFlie::sendSearchPacket(void)
 #define FRAC_MANTISSA 16
 #define FRAC_SCALE ((s32)1 << FRAC_MANTISSA)
 
+// 16.16 per control step for full scale x at CHAN_MAX_VALUE
+#define FRAC_PER_STEP(x) (FRAC_SCALE * (x) / CHAN_MAX_VALUE)
+
+// leading zeros of a nibble
+static const PROGMEM u8 TBL_CLZ4[16] = {
+    4, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
 // Convert fractional 16.16 to float32
+// normalized by bytes and a nibble table instead of bit by bit, at most 3 single bit shifts
 void RFProtocolCFlie::frac2float(s32 n, float* res)
 {
+    u32 m = n < 0 ? -n : n;
+    u8  e = 127 + (31 - FRAC_MANTISSA);
+    u8  clz;
+
     if (n == 0) {
         *res = 0.0;
         return;
     }
-    u32 m = n < 0 ? -n : n;
-    int i;
-    for (i = (31-FRAC_MANTISSA); (m & 0x80000000) == 0; i--, m <<= 1) ;
-    m <<= 1; // Clear implicit leftmost 1
-    m >>= 9;
-    u32 e = 127 + i;
+    if (!(m & 0xffff0000)) {
+        m <<= 16;
+        e -= 16;
+    }
+    if (!(m & 0xff000000)) {
+        m <<= 8;
+        e -= 8;
+    }
+    if (!(m & 0xf0000000)) {
+        m <<= 4;
+        e -= 4;
+    }
+    clz = pgm_read_byte(TBL_CLZ4 + (m >> 28));
+    m <<= clz;
+    e -= clz;
+
+    m = (m >> 8) & 0x7fffff;    // drop implicit leftmost 1
     if (n < 0) m |= 0x80000000;
-    m |= e << 23;
+    m |= (u32)e << 23;
     *((u32 *) res) = m;
 }
 
@@ -109,26 +135,21 @@ void RFProtocolCFlie::sendCmdPacket(void)
     // Channels in AETR order
 
     // Roll, aka aileron, float +- 50.0 in degrees
-    // float roll  = -(float) Channels[0]*50.0/10000;
-    s32 f_roll = -(s32)RFProtocol::getControl(CH_AILERON) * FRAC_SCALE / (10000 / 50);
+    // float roll  = -(float) Channels[0]*50.0/CHAN_MAX_VALUE;
+    s32 f_roll = -(s32)RFProtocol::getControl(CH_AILERON) * FRAC_PER_STEP(50);
 
     // Pitch, aka elevator, float +- 50.0 degrees
-    //float pitch = -(float) Channels[1]*50.0/10000;
-    s32 f_pitch = -(s32)RFProtocol::getControl(CH_ELEVATOR) * FRAC_SCALE / (10000 / 50);
+    //float pitch = -(float) Channels[1]*50.0/CHAN_MAX_VALUE;
+    s32 f_pitch = -(s32)RFProtocol::getControl(CH_ELEVATOR) * FRAC_PER_STEP(50);
 
     // Thrust, aka throttle 0..65535, working range 5535..65535
-    // No space for overshoot here, hard limit Channel3 by -10000..10000
-    s32 ch = (s32)RFProtocol::getControl(CH_THROTTLE);
-    if (ch < CHAN_MIN_VALUE) {
-        ch = CHAN_MIN_VALUE;
-    } else if (ch > CHAN_MAX_VALUE) {
-        ch = CHAN_MAX_VALUE;
-    }
-    uint16_t thrust  = ch*3L + 35535L;
+    // No space for overshoot here, hard limit Channel3 by CHAN_MIN_VALUE..CHAN_MAX_VALUE
+    s16 ch = clamp(RFProtocol::getControl(CH_THROTTLE), CHAN_MIN_VALUE, CHAN_MAX_VALUE);
+    uint16_t thrust  = ch * (30000L / CHAN_MAX_VALUE) + 35535L;
 
     // Yaw, aka rudder, float +- 400.0 deg/s
-    // float yaw   = -(float) Channels[3]*400.0/10000;
-    s32 f_yaw = -(s32)RFProtocol::getControl(CH_RUDDER) * FRAC_SCALE / (10000 / 400);
+    // float yaw   = -(float) Channels[3]*400.0/CHAN_MAX_VALUE;
+    s32 f_yaw = -(s32)RFProtocol::getControl(CH_RUDDER) * FRAC_PER_STEP(400);
     frac2float(f_yaw, &yaw);
   
     // Convert + to X. 181 / 256 = 0.70703125 ~= sqrt(2) / 2
@@ -150,12 +171,10 @@ void RFProtocolCFlie::sendCmdPacket(void)
     mDev.writePayload(mPacketBuf, sizeof(mPacketBuf));
     ++mPacketCtr;
 
-//    radio.ce(HIGH);
-//    delayMicroseconds(15);
     // It saves power to turn off radio after the transmission,
     // so as long as we have pins to do so, it is wise to turn
     // it back.
-//    radio.ce(LOW);
+    mDev.startTx(getPowerMode() != POWER_ALWAYS_ON);
 
     // Check and adjust transmission power. We do this after
     // transmission to not bother with timeout after power
@@ -192,7 +211,7 @@ void RFProtocolCFlie::init1(void)
     mDev.writeReg(NRF24L01_01_EN_AA, 0x01);                 // Auto Acknowledgement for data pipe 0
     mDev.writeReg(NRF24L01_02_EN_RXADDR, 0x01);             // Enable data pipe 0
     mDev.writeReg(NRF24L01_03_SETUP_AW, ADDR_BUF_SIZE - 2);     // 5-byte RX/TX address
-    mDev.writeReg(NRF24L01_04_SETUP_RETR, 0x13);            // 3 retransmits, 500us delay
+    mDev.setRetransmit(1, 3, RETR_MAX_COUNT);               // 3 retransmits, 500us delay, adaptive
 
     mDev.writeReg(NRF24L01_05_RF_CH, mCurRFChan);           // Defined by model id
     mDev.setBitrate(mDataRate);
@@ -232,6 +251,8 @@ void RFProtocolCFlie::init1(void)
 
 u16 RFProtocolCFlie::callState(void)
 {
+    u8 status;
+
     switch (mState) {
     case CFLIE_INIT_SEARCH:
         sendSearchPacket();
@@ -259,8 +280,10 @@ u16 RFProtocolCFlie::callState(void)
         break;
 
     case CFLIE_DATA:
-        if (checkStatus() == PKT_PENDING)
+        status = checkStatus();
+        if (status == PKT_PENDING)
             return PACKET_CHK_uS;               // packet send not yet complete
+        mDev.updateLinkStats(mCurRFChan, status == PKT_ACKED);
         sendCmdPacket();
         break;
     }
@@ -312,8 +335,22 @@ int RFProtocolCFlie::getInfo(s8 id, u8 *data)
                 size = sizeof(mPacketCtr);
                 *((u32*)data) = mPacketCtr;
                 break;
+
+            case INFO_LINK_STATS:
+                size = mDev.getLinkStats(data);
+                break;
         }
     }
     return size;
 }
 
+// searching ends with the ack of the copter
+int RFProtocolCFlie::stopBind(void)
+{
+    return (mState == CFLIE_DATA) ? 0 : -1;
+}
+
+u8 RFProtocolCFlie::getBindProgress(void)
+{
+    return (mState == CFLIE_DATA) ? 100 : 0;
+}
@@ -22,18 +22,21 @@
 class RFProtocolCFlie : public RFProtocol
 {
 #define PAYLOADSIZE          8
-#define MAX_PACKET_SIZE     15
 #define MAX_BIND_COUNT      60
 
 #define PACKET_PERIOD_uS 10000
 #define PACKET_CHK_uS     1000
-#define INITIAL_WAIT_uS  50000
-
-#define ADDR_BUF_SIZE        5
-#define MAX_RF_CHANNELS     20
+#define RETR_MAX_COUNT    8         // (8 + 1) * (500us + air time) within PACKET_PERIOD_uS
 
 public:
-    RFProtocolCFlie(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 15,
+        INITIAL_WAIT_uS = 50000,
+        ADDR_BUF_SIZE   = 5,
+        MAX_RF_CHANNELS = 20,
+    };
+
+    RFProtocolCFlie(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolCFlie() { close(); }
 
 // for protocol
@@ -42,6 +45,13 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
+    virtual void sleep(void)        { mDev.powerDown(); }
+    virtual void wake(void)         { mDev.powerUp();   }
+
+    // 16.16 fixed point to IEEE float32, checked by tools/frac_check
+    static void frac2float(s32 n, float* res);
 
 private:
     u8   checkStatus(void);
@@ -49,7 +59,6 @@ private:
     void init1(void);
     void setRateAndCh(u8 rate, u8 channel);
     void sendSearchPacket(void);
-    void frac2float(s32 n, float* res);
     void sendCmdPacket(void);
 
 // variables
@@ -15,6 +15,8 @@
 
 #include <SPI.h>
 #include "RFProtocolDevo.h"
+#include "ChanScale.h"
+#include "Storage.h"
 #include "utils.h"
 
 #define PKTS_PER_CHANNEL        4
@@ -24,6 +26,21 @@
 #define PACKET_PERIOD_uS     1200
 #define INITIAL_WAIT_uS      2400
 
+#define PROTO_OPT_CACHED_CHANNELS   0x40
+#define PROTO_OPT_TELEMETRY         0x80
+
+// telemetry : TX_WAIT_uS + RX_POLL_uS * (RX_POLL_END - 1) = 2 * PACKET_PERIOD_uS
+#define TX_WAIT_uS            900
+#define RX_POLL_uS            100
+#define RX_POLL_END            16
+#define RX_QUALITY_PERIOD      32
+
+// channel survey : 270us per channel with 3 RSSI samples, stops after 3 clean channels
+#define SURVEY_DWELL_uS       270
+#define SURVEY_SAMPLES          3
+#define SURVEY_QUIET_RSSI       4
+#define SURVEY_MAX_AGE          8       // boots a cached survey stays valid
+
 enum PktState {
     DEVO_BIND,
     DEVO_BIND_SENDCH,
@@ -88,24 +105,23 @@ void RFProtocolDevo::buildBeaconPacket(int upper)
     int max    = 8;
     int offset = 0;
 
-    mPacketBuf[0] = ((mConChanCnt << 4) | 0x07);    
+    mPacketBuf[0] = ((getChannelCount() << 4) | 0x07);    
     if (upper) {
         mPacketBuf[0] += 1;
         max = 4;
         offset = 8;
     }
 
+    // receiver holds failsafe values in percent
     for(int i = 0; i < max; i++) {
-#ifdef BOGUS
-        if (i + offset < Model.mConChanCnt && Model.limits[i+offset].flags & CH_FAILSAFE_EN) {
+        u8 ch = getControlIdxByOrder(i + offset);
+
+        if (i + offset < getChannelCount() && (getFailsafeMask() & BV(ch))) {
             enable |= 0x80 >> i;
-            mPacketBuf[i+1] = Model.limits[i+offset].failsafe;
+            mPacketBuf[i + 1] = clamp(ChanScale<100>::scale(getFailsafe(ch)), -125, 125);
         } else {
-#endif /* BOGUS */
             mPacketBuf[i + 1] = 0;
-#ifdef BOGUS
         }
-#endif /* BOGUS */
     }
     mPacketBuf[9] = enable;
     addPacketSuffix();
@@ -113,7 +129,7 @@ void RFProtocolDevo::buildBeaconPacket(int upper)
 
 void RFProtocolDevo::buildBindPacket(void)
 {
-    mPacketBuf[0] = (mConChanCnt << 4) | 0x0a;
+    mPacketBuf[0] = (getChannelCount() << 4) | 0x0a;
     mPacketBuf[1] = mBindCtr & 0xff;
     mPacketBuf[2] = (mBindCtr >> 8);
     mPacketBuf[3] = *mCurRFChPtr;
@@ -134,23 +150,33 @@ void RFProtocolDevo::buildBindPacket(void)
 void RFProtocolDevo::buildDataPacket(void)
 {
     s32 value;
-    u8 i;
-    u8 sign = 0x0b;
-    
-    mPacketBuf[0] = (mConChanCnt << 4) | (0x0b + mConChanIdx);
+    u8  i;
+    u8  ch;
+    u8  base = mConChanIdx * 4;
+    u8  *signs = &mChanSigns[mConChanIdx];
+
+    // a packet carries one group, changes of the others wait for their turn
+    mChanDirty |= fetchDirty();
+    mPacketBuf[0] = (getChannelCount() << 4) | (0x0b + mConChanIdx);
     for (i = 0; i < 4; i++) {
-        value = (s32)getControlByOrder(i) * 0x640 / CHAN_MAX_VALUE;
-        if(value < 0) {
-            value = -value;
-            sign |= 1 << (7 - i);
+        ch = getControlIdxByOrder(base + i);
+        if (mChanDirty & BV(ch)) {
+            mChanDirty &= ~BV(ch);
+            value = ChanScale<0x640>::scale(getControl(ch));
+            *signs &= ~(1 << (7 - i));
+            if(value < 0) {
+                value = -value;
+                *signs |= 1 << (7 - i);
+            }
+            mChanVals[base + i] = value;
         }
-        mPacketBuf[2 * i + 1] = value & 0xff;
-        mPacketBuf[2 * i + 2] = (value >> 8) & 0xff;
+        mPacketBuf[2 * i + 1] = mChanVals[base + i] & 0xff;
+        mPacketBuf[2 * i + 2] = (mChanVals[base + i] >> 8) & 0xff;
     }
-    mPacketBuf[9] = sign;
+    mPacketBuf[9] = *signs | 0x0b;
 
     mConChanIdx = mConChanIdx + 1;
-    if (mConChanIdx * 4 >= mConChanCnt)
+    if (mConChanIdx * 4 >= getChannelCount())
         mConChanIdx = 0;
     addPacketSuffix();
 }
@@ -179,26 +205,10 @@ s32 RFProtocolDevo::convFloatStr2Int(u8 *ptr)
     return value;
 }
 
-void RFProtocolDevo::parseTelemetryPacket(u8 *mPacketBuf)
+void RFProtocolDevo::parseTelemetryPacket(void)
 {
-#ifdef BOGUS
-
-    static const u8 voltpkt[] = {
-            TELEM_DEVO_VOLT1, TELEM_DEVO_VOLT2, TELEM_DEVO_VOLT3,
-            TELEM_DEVO_RPM1, TELEM_DEVO_RPM2, 0
-        };
-    static const u8 temppkt[] = {
-            TELEM_DEVO_TEMP1, TELEM_DEVO_TEMP2, TELEM_DEVO_TEMP3, TELEM_DEVO_TEMP4, 0
-        };
-    static const u8 gpslongpkt[] = { TELEM_GPS_LONG, 0};
-    static const u8 gpslatpkt[] = { TELEM_GPS_LAT, 0};
-    static const u8 gpsaltpkt[] = { TELEM_GPS_ALT, 0};
-    static const u8 gpsspeedpkt[] = { TELEM_GPS_SPEED, 0};
-    static const u8 gpstimepkt[] = { TELEM_GPS_TIME, 0};
-
     if((mPacketBuf[0] & 0xF0) != 0x30)
         return;
-    const u8 *update = NULL;
     buildScramblePacket(); //This will unscramble the mPacketBuf
     if (mPacketBuf[13] != (mFixedID  & 0xff)
         || mPacketBuf[14] != ((mFixedID >> 8) & 0xff)
@@ -206,23 +216,18 @@ void RFProtocolDevo::parseTelemetryPacket(u8 *mPacketBuf)
     {
         return;
     }
-    //if (mPacketBuf[0] < 0x37) {
-    //    memcpy(Telemetry.line[mPacketBuf[0]-0x30], mPacketBuf+1, 12);
-    //}
     if (mPacketBuf[0] == TELEMETRY_ENABLE) {
-        update = voltpkt;
-        Telemetry.p.devo.volt[0] = mPacketBuf[1]; //In 1/10 of Volts
-        Telemetry.p.devo.volt[1] = mPacketBuf[3]; //In 1/10 of Volts
-        Telemetry.p.devo.volt[2] = mPacketBuf[5]; //In 1/10 of Volts
-        Telemetry.p.devo.rpm[0]  = mPacketBuf[7] * 120; //In RPM
-        Telemetry.p.devo.rpm[1]  = mPacketBuf[9] * 120; //In RPM
+        mTelemetry.updated |= TELEM_VOLT;
+        mTelemetry.volt[0] = mPacketBuf[1]; //In 1/10 of Volts
+        mTelemetry.volt[1] = mPacketBuf[3]; //In 1/10 of Volts
+        mTelemetry.volt[2] = mPacketBuf[5]; //In 1/10 of Volts
+        mTelemetry.rpm[0]  = mPacketBuf[7] * 120; //In RPM
+        mTelemetry.rpm[1]  = mPacketBuf[9] * 120; //In RPM
     }
     if (mPacketBuf[0] == 0x31) {
-        update = temppkt;
-        Telemetry.p.devo.temp[0] = mPacketBuf[1] == 0xff ? 0 : mPacketBuf[1] - 20; //In degrees-C
-        Telemetry.p.devo.temp[1] = mPacketBuf[2] == 0xff ? 0 : mPacketBuf[2] - 20; //In degrees-C
-        Telemetry.p.devo.temp[2] = mPacketBuf[3] == 0xff ? 0 : mPacketBuf[3] - 20; //In degrees-C
-        Telemetry.p.devo.temp[3] = mPacketBuf[4] == 0xff ? 0 : mPacketBuf[4] - 20; //In degrees-C
+        mTelemetry.updated |= TELEM_TEMP;
+        for (u8 i = 0; i < 4; i++)
+            mTelemetry.temp[i] = mPacketBuf[i + 1] == 0xff ? 0 : mPacketBuf[i + 1] - 20; //In degrees-C
     }
     /* GPS Data
        32: 30333032302e3832373045fb  = 030°20.8270E
@@ -232,48 +237,59 @@ void RFProtocolDevo::parseTelemetryPacket(u8 *mPacketBuf)
        36: 313832353532313531303132  = 2012-10-15 18:25:52 (UTC)
     */
     if (mPacketBuf[0] == 0x32) {
-        update = gpslongpkt;
-        Telemetry.gps.longitude = ((mPacketBuf[1]-'0') * 100 + (mPacketBuf[2]-'0') * 10 + (mPacketBuf[3]-'0')) * 3600000
-                                  + ((mPacketBuf[4]-'0') * 10 + (mPacketBuf[5]-'0')) * 60000
-                                  + ((mPacketBuf[7]-'0') * 1000 + (mPacketBuf[8]-'0') * 100
-                                     + (mPacketBuf[9]-'0') * 10 + (mPacketBuf[10]-'0')) * 6;
+        mTelemetry.updated |= TELEM_GPS_LONG;
+        mTelemetry.longitude = ((mPacketBuf[1]-'0') * 100 + (mPacketBuf[2]-'0') * 10 + (mPacketBuf[3]-'0')) * 3600000L
+                             + ((mPacketBuf[4]-'0') * 10 + (mPacketBuf[5]-'0')) * 60000L
+                             + ((mPacketBuf[7]-'0') * 1000 + (mPacketBuf[8]-'0') * 100
+                                + (mPacketBuf[9]-'0') * 10 + (mPacketBuf[10]-'0')) * 6L;
         if (mPacketBuf[11] == 'W')
-            Telemetry.gps.longitude *= -1;
+            mTelemetry.longitude *= -1;
     }
     if (mPacketBuf[0] == 0x33) {
-        update = gpslatpkt;
-        Telemetry.gps.latitude = ((mPacketBuf[1]-'0') * 10 + (mPacketBuf[2]-'0')) * 3600000
-                                  + ((mPacketBuf[3]-'0') * 10 + (mPacketBuf[4]-'0')) * 60000
-                                  + ((mPacketBuf[6]-'0') * 1000 + (mPacketBuf[7]-'0') * 100
-                                     + (mPacketBuf[8]-'0') * 10 + (mPacketBuf[9]-'0')) * 6;
+        mTelemetry.updated |= TELEM_GPS_LAT;
+        mTelemetry.latitude = ((mPacketBuf[1]-'0') * 10 + (mPacketBuf[2]-'0')) * 3600000L
+                            + ((mPacketBuf[3]-'0') * 10 + (mPacketBuf[4]-'0')) * 60000L
+                            + ((mPacketBuf[6]-'0') * 1000 + (mPacketBuf[7]-'0') * 100
+                               + (mPacketBuf[8]-'0') * 10 + (mPacketBuf[9]-'0')) * 6L;
         if (mPacketBuf[10] == 'S')
-            Telemetry.gps.latitude *= -1;
+            mTelemetry.latitude *= -1;
     }
     if (mPacketBuf[0] == 0x34) {
-        update = gpsaltpkt;
-        Telemetry.gps.altitude = convFloatStr2Int(mPacketBuf+1);
+        mTelemetry.updated |= TELEM_GPS_ALT;
+        mTelemetry.altitude = convFloatStr2Int(mPacketBuf+1);
     }
     if (mPacketBuf[0] == 0x35) {
-        update = gpsspeedpkt;
-        Telemetry.gps.velocity = convFloatStr2Int(mPacketBuf+7);
+        mTelemetry.updated |= TELEM_GPS_SPEED;
+        mTelemetry.velocity = convFloatStr2Int(mPacketBuf+7);
     }
     if (mPacketBuf[0] == 0x36) {
-        update = gpstimepkt;
+        mTelemetry.updated |= TELEM_GPS_TIME;
         u8 hour  = (mPacketBuf[1]-'0') * 10 + (mPacketBuf[2]-'0');
         u8 min   = (mPacketBuf[3]-'0') * 10 + (mPacketBuf[4]-'0');
         u8 sec   = (mPacketBuf[5]-'0') * 10 + (mPacketBuf[6]-'0');
         u8 day   = (mPacketBuf[7]-'0') * 10 + (mPacketBuf[8]-'0');
         u8 month = (mPacketBuf[9]-'0') * 10 + (mPacketBuf[10]-'0');
         u8 year  = (mPacketBuf[11]-'0') * 10 + (mPacketBuf[12]-'0'); // + 2000
-        Telemetry.gps.time = ((year & 0x3F) << 26)
-                           | ((month & 0x0F) << 22)
-                           | ((day & 0x1F) << 17)
-                           | ((hour & 0x1F) << 12)
-                           | ((min & 0x3F) << 6)
-                           | ((sec & 0x3F) << 0);
+        mTelemetry.time = ((u32)(year & 0x3F) << 26)
+                        | ((u32)(month & 0x0F) << 22)
+                        | ((u32)(day & 0x1F) << 17)
+                        | ((u32)(hour & 0x1F) << 12)
+                        | ((min & 0x3F) << 6)
+                        | ((sec & 0x3F) << 0);
     }
+}
 
-#endif /* BOGUS */
+// quality is the % of receive windows with a frame over the last RX_QUALITY_PERIOD windows
+void RFProtocolDevo::updateLinkQuality(bool received)
+{
+    if (received)
+        mRxFrames++;
+    if (++mRxWindows == RX_QUALITY_PERIOD) {
+        mTelemetry.quality = ((u16)mRxFrames * 100) / RX_QUALITY_PERIOD;
+        mTelemetry.updated |= TELEM_LINK;
+        mRxWindows = 0;
+        mRxFrames  = 0;
+    }
 }
 
 void RFProtocolDevo::setBoundSOPCodes(void)
@@ -313,16 +329,19 @@ static const PROGMEM u8 TBL_INIT_REGS[] = {
     CYRF_0F_XACT_CFG,       0x28
 };
 
-void RFProtocolDevo::init1(void)
+// bound : the channels come from the bind record, no survey
+void RFProtocolDevo::init1(bool bound)
 {
     /* Initialise CYRF chip */
+    mDev.initialize();
     mDev.reset();
 
     mDev.readMfgID(mMfgIDBuf);
     mDev.setTxRxMode(TX_EN);
     mDev.setCRCSeed(0x0000);
     mDev.setSOPCode_P(SOPCODES[0]);
-    setRadioChannels();
+    if (!bound)
+        setRadioChannels();
 
     u8 reg, val;
     for (u8 i = 0; i < sizeof(TBL_INIT_REGS) / 2; i++) {
@@ -336,12 +355,51 @@ void RFProtocolDevo::init1(void)
 
 void RFProtocolDevo::setRadioChannels(void)
 {
-    mDev.findBestChannels(mRFChanBufs, 3, 4, 4, 80);
+    u32 key = *(u32*)mMfgIDBuf;
+    s16 age = -1;
+
+    bool cached = getProtocolOpt() & PROTO_OPT_CACHED_CHANNELS;
+
+    if (cached)
+        age = Storage::read(Storage::SLOT_CYRF_CHANNELS, key, mRFChanBufs, 3);
+
+    if (age < 0 || age > SURVEY_MAX_AGE) {
+        mDev.findBestChannels(mRFChanBufs, 3, 4, 4, 80, SURVEY_DWELL_uS, SURVEY_SAMPLES, SURVEY_QUIET_RSSI);
+        if (cached)
+            Storage::write(Storage::SLOT_CYRF_CHANNELS, key, mRFChanBufs, 3);
+    }
     //Makes code a little easier to duplicate these here
     mRFChanBufs[3] = mRFChanBufs[0];
     mRFChanBufs[4] = mRFChanBufs[1];
 }
 
+typedef struct {
+    u32  fixedID;
+    u8   rfChans[3];
+} BIND_T;
+
+bool RFProtocolDevo::loadBindData(void)
+{
+    BIND_T bind;
+
+    if (!loadBind(&bind, sizeof(bind)))
+        return false;
+    mFixedID = bind.fixedID;
+    memcpy(mRFChanBufs, bind.rfChans, sizeof(bind.rfChans));
+    mRFChanBufs[3] = mRFChanBufs[0];
+    mRFChanBufs[4] = mRFChanBufs[1];
+    return true;
+}
+
+void RFProtocolDevo::saveBindData(void)
+{
+    BIND_T bind;
+
+    bind.fixedID = mFixedID;
+    memcpy(bind.rfChans, mRFChanBufs, sizeof(bind.rfChans));
+    saveBind(&bind, sizeof(bind));
+}
+
 void RFProtocolDevo::buildPacket(void)
 {
     switch(mState) {
@@ -357,6 +415,7 @@ void RFProtocolDevo::buildPacket(void)
             buildScramblePacket();
             if (mBindCtr <= 0) {
                 mState = DEVO_BOUND;
+                saveBindData();
 //                PROTOCOL_SetBindState(0);
             } else {
                 mState = DEVO_BIND;
@@ -385,7 +444,7 @@ void RFProtocolDevo::buildPacket(void)
             break;
             
         case DEVO_BOUND_10:
-            buildBeaconPacket(mConChanCnt > 8 ? failsafe_pkt : 0);
+            buildBeaconPacket(getChannelCount() > 8 ? failsafe_pkt : 0);
             failsafe_pkt = failsafe_pkt ? 0 : 1;
             buildScramblePacket();
             mState = DEVO_BOUND_1;
@@ -397,83 +456,77 @@ void RFProtocolDevo::buildPacket(void)
         mPacketCtr = 0;
 }
 
-#ifdef BOGUS
-u16 RFProtocolDevo::callState2(void)
+#define NUM_WAIT_LOOPS (100 / 5) //each loop is ~5us.  Do not wait more than 100us
+
+// one packet every 2 periods like callState(), the receiver answers in the gap.
+// 900us after TX the radio listens and is polled every RX_POLL_uS until 2400us are over.
+u16 RFProtocolDevo::callStateTelemetry(void)
 {
     if (mTxState == 0) {
         mTxState = 1;
         buildPacket();
-        mDev.writePayload(mPacketBuf);
-        return 900;
+        mDev.writePayload(mPacketBuf, MAX_PACKET_SIZE);
+        return TX_WAIT_uS;
     }
-    int delay = 100;
+
+    u16 delay = RX_POLL_uS;
     if (mTxState == 1) {
-        int i = 0;
-        while (! (mDev.readReg(0x04) & 0x02)) {
-            if(++i > NUM_WAIT_LOOPS) {
-                delay = 1500;
-                mTxState = 15;
+        u8 i = 0;
+        while (! (mDev.readReg(CYRF_04_TX_IRQ_STATUS) & 0x02)) {
+            if(++i > NUM_WAIT_LOOPS)
                 break;
-            }
         }
-     
+
         if (mState == DEVO_BOUND) {
             /* exit binding mState */
             mState = DEVO_BOUND_3;
             setBoundSOPCodes();
         }
         if(mPacketCtr == 0 || mBindCtr > 0) {
-            delay = 1500;
-            mTxState = 15;
+            // no answer before hopping or while binding
+            delay = RX_POLL_uS * (RX_POLL_END - 1);
+            mTxState = RX_POLL_END - 1;
         } else {
             mDev.setTxRxMode(RX_EN); //Receive mode
             mDev.writeReg(CYRF_07_RX_IRQ_STATUS, 0x80); //Prepare to receive
             mDev.writeReg(CYRF_05_RX_CTRL, 0x80); //Prepare to receive (do not enable any IRQ)
         }
     } else {
-        int reg = mDev.readReg(0x07);
-        if ((reg & 0x23) == 0x22)
-        //if(mDev.readReg(0x07) & 0x20)
-        { // this won't be true in emulator so we need to simulate it somehow
-            mDev.readPayload(mPacketBuf);
-            parseTelemetryPacket(mPacketBuf);
-            delay = 100 * (16 - mTxState);
-            mTxState = 15;
+        u8 reg = mDev.readReg(CYRF_07_RX_IRQ_STATUS);
+        bool received = ((reg & 0x23) == 0x22);
+
+        if (received) {
+            mTelemetry.rssi = mDev.readReg(CYRF_13_RSSI) & 0x1f;
+            mDev.readPayload(mPacketBuf, MAX_PACKET_SIZE);
+            parseTelemetryPacket();
+            delay = RX_POLL_uS * (RX_POLL_END - mTxState);
+            mTxState = RX_POLL_END - 1;
         }
-#ifdef EMULATOR
-        u8 telem_bit = rand32() % 7; // random number in [0, 7)
-        mPacketBuf[0] =  TELEMETRY_ENABLE + telem_bit; // allow emulator to simulate telemetry parsing to prevent future bugs in the telemetry monitor
-        //printf("telem 1st mPacketBuf: 0x%x\n", mPacketBuf[0]);
-        for(int i = 1; i < 13; i++)
-            mPacketBuf[i] = rand32() % 256;
-        parseTelemetryPacket(mPacketBuf);
-        for(int i = 0; i < TELEM_UPDATE_SIZE; i++)
-            Telemetry.updated[i] = 0xff;
-        delay = 100 * (16 - mTxState);
-        mTxState = 15;
-#endif
+        if (received || mTxState == RX_POLL_END - 1)
+            updateLinkQuality(received);
     }
+
     mTxState++;
-    if(mTxState == 16) { //2.3msec have passed
+    if(mTxState == RX_POLL_END) {
         mDev.setTxRxMode(TX_EN); //Write mode
         if(mPacketCtr == 0) {
             //Keep tx power updated
-            mDev.writeReg(CYRF_03_TX_CFG, 0x08 | Model.tx_power);
-            mCurRFChPtr = mCurRFChPtr == &mRFChanBufs[2] ? mRFChanBufs : mCurRFChPtr + 1;
-            CYRF_ConfigRFChannel(*mCurRFChPtr);
+            mDev.writeReg(CYRF_03_TX_CFG, 0x08 | getRFPower());
+            mCurRFChPtr = (mCurRFChPtr == &mRFChanBufs[2]) ? mRFChanBufs : (mCurRFChPtr + 1);
+            mDev.setRFChannel(*mCurRFChPtr);
         }
         mTxState = 0;
     }
-    return PACKET_PERIOD_uS;
+    return delay;
 }
-#endif /* BOGUS */
-
-#define NUM_WAIT_LOOPS (100 / 5) //each loop is ~5us.  Do not wait more than 100us
 
 u16 RFProtocolDevo::callState(void)
 {
     int i = 0;
-    
+
+    if (getProtocolOpt() & PROTO_OPT_TELEMETRY)
+        return callStateTelemetry();
+
     if (mTxState == 0) {
         mTxState = 1;
         buildPacket();
@@ -502,19 +555,30 @@ u16 RFProtocolDevo::callState(void)
 
 int RFProtocolDevo::init(void)
 {
-    init1();
+    // the receiver keeps the bound id and channels
+    bool resume = isResume() && loadBindData();
+
+    init1(resume);
 
     mBoolFixedID = 0;
     failsafe_pkt = 0;
     mCurRFChPtr = mRFChanBufs;
-//    memset(&Telemetry, 0, sizeof(Telemetry));
 
     mDev.setRFChannel(*mCurRFChPtr);
     mPacketCtr = 0;
     mConChanIdx = 0;
+    memset(mChanSigns, 0, sizeof(mChanSigns));
+    mChanDirty = (1 << MAX_CHANNEL) - 1;
     mTxState = 0;
+    memset(&mTelemetry, 0, sizeof(mTelemetry));
+    mRxWindows = 0;
+    mRxFrames  = 0;
 
-    if(1) {  // ! Model.mFixedID
+    if (resume) {
+        mBindCtr = 0;
+        mState   = DEVO_BOUND_1;
+        setBoundSOPCodes();
+    } else if(1) {  // ! Model.mFixedID
         mFixedID = ((u32)(mRFChanBufs[0] ^ mMfgIDBuf[0] ^ mMfgIDBuf[3]) << 16)
                  | ((u32)(mRFChanBufs[1] ^ mMfgIDBuf[1] ^ mMfgIDBuf[4]) << 8)
                  | ((u32)(mRFChanBufs[2] ^ mMfgIDBuf[2] ^ mMfgIDBuf[5]) << 0);
@@ -535,6 +599,15 @@ int RFProtocolDevo::init(void)
     return 0;
 }
 
+// 4, 8 or 12 channels, 4 in a data packet
+int RFProtocolDevo::setChannelCount(u8 cnt)
+{
+    if (cnt == 0 || RFProtocol::setChannelCount((cnt + 3) & ~3) < 0)
+        return -1;
+    mConChanIdx = 0;
+    return 0;
+}
+
 int RFProtocolDevo::close(void)
 {
     //printf(F("%08ld : %s\n"), millis(), __PRETTY_FUNCTION__);
@@ -575,3 +648,19 @@ int RFProtocolDevo::getInfo(s8 id, u8 *data)
     return size;
 }
 
+// DEVO_BIND_SENDCH moves to DEVO_BOUND when the counter reaches 0
+int RFProtocolDevo::stopBind(void)
+{
+    if (mState == DEVO_BIND)
+        mBindCtr = 2;
+    else if (mState == DEVO_BIND_SENDCH)
+        mBindCtr = 1;
+    return 0;
+}
+
+u8 RFProtocolDevo::getBindProgress(void)
+{
+    if (mState == DEVO_BIND || mState == DEVO_BIND_SENDCH)
+        return calcBindProgress(mBindCtr, MAX_BIND_COUNT);
+    return 100;
+}
@@ -22,14 +22,16 @@
 
 class RFProtocolDevo : public RFProtocol
 {
-#define MAX_PACKET_SIZE        16
-#define ADDR_BUF_SIZE           5
 #define MFG_ID_SIZE             6
-#define MAX_RF_CHANNELS         5
-
 
 public:
-    RFProtocolDevo(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 16,
+        ADDR_BUF_SIZE   = 5,
+        MAX_RF_CHANNELS = 5,
+    };
+
+    RFProtocolDevo(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolDevo() { close(); }
 
 // for protocol
@@ -38,18 +40,26 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
+    virtual TELEMETRY_T *getTelemetry(void) { return &mTelemetry; }
+    virtual int  setChannelCount(u8 cnt);
 
 private:
-    void init1(void);
+    void init1(bool bound);
     void buildScramblePacket(void);
     void addPacketSuffix(void);
     void buildBeaconPacket(int upper);
     void buildBindPacket(void);
     void buildDataPacket(void);
     s32  convFloatStr2Int(u8 *ptr);
-    void parseTelemetryPacket(u8 *mPacketBuf);
+    void parseTelemetryPacket(void);
+    void updateLinkQuality(bool received);
+    u16  callStateTelemetry(void);
     void setBoundSOPCodes(void);
     void setRadioChannels(void);
+    bool loadBindData(void);
+    void saveBindData(void);
     void buildPacket(void);
     
 
@@ -58,12 +68,14 @@ private:
     u16  mBindCtr;
     u8   mRFChanBufs[MAX_RF_CHANNELS];
     u8   mPacketBuf[MAX_PACKET_SIZE];
+    u16  mChanVals[MAX_CHANNEL];    // encoded magnitude of channels in AETR order
+    u8   mChanSigns[MAX_CHANNEL / 4];   // sign bits as placed in the packet of each group
+    u16  mChanDirty;        // changed controls not yet encoded
     u8   mRxTxAddrBuf[ADDR_BUF_SIZE];
     u8   mMfgIDBuf[MFG_ID_SIZE];
 
     u8   mPacketCtr;    
-    u8   mConChanIdx;
-    u8   mConChanCnt;
+    u8   mConChanIdx;       // group of 4 channels in the next data packet
     u8   mPacketSize;
     u8   mState;
     u8   mTxState;
@@ -73,6 +85,10 @@ private:
     u32 mFixedID;
     u8 *mCurRFChPtr;
 
+    TELEMETRY_T mTelemetry;
+    u8   mRxWindows;        // receive windows opened in the current quality period
+    u8   mRxFrames;         // valid frames in the current quality period
+
 protected:
 
 };
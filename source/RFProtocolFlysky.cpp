@@ -15,6 +15,8 @@
 
 #include <SPI.h>
 #include "RFProtocolFlysky.h"
+#include "ChanScale.h"
+#include "Storage.h"
 #include "utils.h"
 
 #define MAX_BIND_COUNT          2500
@@ -23,6 +25,7 @@
 #define PROTO_OPT_WLTOYS_V9X9   0x01
 #define PROTO_OPT_WLTOYS_V6X6   0x02
 #define PROTO_OPT_WLTOYS_V912   0x03
+#define PROTO_OPT_WLTOYS_MASK   0x03
 
 enum {
     // flags going to byte 10
@@ -78,35 +81,16 @@ static const PROGMEM u8 TBL_TX_CHANS[16][16] = {
   {0x64, 0x14, 0x82, 0x32, 0x6e, 0x1e, 0x78, 0x28, 0x8c, 0x3c, 0xa0, 0x50, 0x5a, 0x0a, 0x96, 0x46},
 };
 
-int RFProtocolFlysky::init1(void)
+int RFProtocolFlysky::calibrate(void)
 {
     u8 if_calibration1;
     u8 vco_calibration0;
     u8 vco_calibration1;
-    //u8 vco_current;
-
-    mDev.writeID(0x5475c52a);
-    u8 reg;
-    for (u8 i = 0; i < 0x33; i++) {
-        reg = pgm_read_byte(TBL_INIT_REGS + i);
-        if((s8)reg != -1)
-            mDev.writeReg(i, reg);
-    }
-    mDev.strobe(A7105_STANDBY);
 
     //IF Filter Bank Calibration
-    mDev.writeReg(0x02, 1);
-    //vco_current =
-    mDev.readReg(0x02);
-
-    u32 ms = millis();
-    while(millis()  - ms < 500) {
-        if(! mDev.readReg(0x02))
-            break;
-    }
-    if (millis() - ms >= 500)
+    if (!mDev.calibrate(1))
         return 0;
-    
+
     if_calibration1 = mDev.readReg(A7105_22_IF_CALIB_I);
     mDev.readReg(A7105_24_VCO_CURCAL);
     if(if_calibration1 & A7105_MASK_FBCF) {
@@ -125,13 +109,7 @@ int RFProtocolFlysky::init1(void)
     mDev.writeReg(A7105_0F_CHANNEL, 0);
     
     //VCO Calibration
-    mDev.writeReg(0x02, 2);
-    ms = millis();
-    while(millis()  - ms < 500) {
-        if(! mDev.readReg(0x02))
-            break;
-    }
-    if (millis() - ms >= 500)
+    if (!mDev.calibrate(2))
         return 0;
 
     vco_calibration0 = mDev.readReg(A7105_25_VCO_SBCAL_I);
@@ -144,13 +122,7 @@ int RFProtocolFlysky::init1(void)
     //Set Channel
     mDev.writeReg(A7105_0F_CHANNEL, 0xa0);
     //VCO Calibration
-    mDev.writeReg(A7105_02_CALC, 2);
-    ms = millis();
-    while(millis()  - ms < 500) {
-        if(! mDev.readReg(A7105_02_CALC))
-            break;
-    }
-    if (millis() - ms >= 500)
+    if (!mDev.calibrate(2))
         return 0;
 
     vco_calibration1 = mDev.readReg(A7105_25_VCO_SBCAL_I);
@@ -158,6 +130,32 @@ int RFProtocolFlysky::init1(void)
         //Calibration failed...what do we do?
     }
 
+    return 1;
+}
+
+int RFProtocolFlysky::init1(void)
+{
+    u8 cal[A7105_CALIB_SIZE];
+    u32 key = getModule();                  // the chip, not the protocol
+
+    mDev.writeID(0x5475c52a);
+    u8 reg;
+    for (u8 i = 0; i < 0x33; i++) {
+        reg = pgm_read_byte(TBL_INIT_REGS + i);
+        if((s8)reg != -1)
+            mDev.writeReg(i, reg);
+    }
+    mDev.strobe(A7105_STANDBY);
+
+    // reuse the last good calibration, run the full one only if it is refused
+    if (Storage::read(Storage::SLOT_A7105_CALIB, key, cal, sizeof(cal)) < 0 || !mDev.setCalibration(cal)) {
+        if (!calibrate())
+            return 0;
+        mDev.getCalibration(cal);
+        if (mDev.setCalibration(cal))
+            Storage::write(Storage::SLOT_A7105_CALIB, key, cal, sizeof(cal));
+    }
+
     //Reset VCO Band calibration
     mDev.writeReg(0x25, 0x08);
     mDev.setTxRxMode(TX_EN);
@@ -175,7 +173,7 @@ void RFProtocolFlysky::applyExtFlags(void)
 {
     static u8 seq;
 
-    switch (getProtocolOpt() & PROTO_OPT_WLTOYS_V9X9) {
+    switch (getProtocolOpt() & PROTO_OPT_WLTOYS_MASK) {
         case PROTO_OPT_WLTOYS_V9X9:
             if (getControlByOrder(4) > 0)
                 mPacketBuf[12] |= FLAG_V9X9_LED;
@@ -254,12 +252,16 @@ void RFProtocolFlysky::buildPacket(u8 init)
     mPacketBuf[2] = (mTXID >>  8) & 0xff;
     mPacketBuf[3] = (mTXID >> 16) & 0xff;
     mPacketBuf[4] = (mTXID >> 24) & 0xff;
+    u16 dirty = fetchDirty();
     for (u8 i = 0; i < 8; i++) {
-        s32 value = (s32)getControlByOrder(i) * 0x1f1 / CHAN_MAX_VALUE + 0x5d9;
-        if (value < 0)
-            value = 0;
-        mPacketBuf[5 + i * 2] = value & 0xff;
-        mPacketBuf[6 + i * 2] = (value >> 8) & 0xff;
+        if (dirty & BV(getControlIdxByOrder(i))) {
+            s32 value = ChanScale<0x1f1>::scale(getControlByOrder(i)) + 0x5d9;
+            if (value < 0)
+                value = 0;
+            mChanVals[i] = value;
+        }
+        mPacketBuf[5 + i * 2] = mChanVals[i] & 0xff;
+        mPacketBuf[6 + i * 2] = (mChanVals[i] >> 8) & 0xff;
     }
     applyExtFlags();
 }
@@ -271,13 +273,15 @@ u16 RFProtocolFlysky::callState(void)
         mCurRFChan = 1;
         mDev.writeData(mPacketBuf, MAX_PACKET_SIZE, mCurRFChan);
         mBindCtr--;
+        if (!mBindCtr)
+            saveBind(&mTXID, sizeof(mTXID));
 #ifdef BOGUS
         if (!mBindCtr)
             PROTOCOL_SetBindState(0);
 #endif /* BOGUS */
     } else {
         buildPacket(0);
-        mCurRFChan = pgm_read_byte(TBL_TX_CHANS + mCurRFChanRow * 16 + mCurRFChanCol) - mRFChanOffset;
+        mCurRFChan = pgm_read_byte(&TBL_TX_CHANS[mCurRFChanRow][mCurRFChanCol]) - mRFChanOffset;
         mDev.writeData(mPacketBuf, MAX_PACKET_SIZE, mCurRFChan);
         mCurRFChanCol = (mCurRFChanCol + 1) % 16;
         if (!mCurRFChanCol)                                 //Keep transmit power updated
@@ -290,6 +294,7 @@ u16 RFProtocolFlysky::callState(void)
 
 int RFProtocolFlysky::init(void)
 {
+    mDev.initialize();
     while (1) {
         mDev.reset();
         if (init1())
@@ -302,10 +307,16 @@ int RFProtocolFlysky::init(void)
         mTXID = mTXID - 0x70;
 
     mCurRFChanRow = mTXID % 16;
+    mCurRFChanCol = 0;
     mRFChanOffset = (mTXID & 0xff) / 16;
     mBindCtr      = MAX_BIND_COUNT;
     mPacketCtr    = 0;
 
+    // channels come from controller id, the record tells the receiver was bound
+    u32 id;
+    if (isResume() && loadBind(&id, sizeof(id)) && id == mTXID)
+        mBindCtr = 0;
+
     startState(INITIAL_WAIT_uS);
 
     return 0;
@@ -351,3 +362,14 @@ int RFProtocolFlysky::getInfo(s8 id, u8 *data)
     return size;
 }
 
+int RFProtocolFlysky::stopBind(void)
+{
+    if (mBindCtr > 1)
+        mBindCtr = 1;
+    return 0;
+}
+
+u8 RFProtocolFlysky::getBindProgress(void)
+{
+    return calcBindProgress(mBindCtr, MAX_BIND_COUNT);
+}
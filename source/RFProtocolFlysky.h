@@ -22,10 +22,13 @@
 
 class RFProtocolFlysky : public RFProtocol
 {
-#define MAX_PACKET_SIZE         21
 
 public:
-    RFProtocolFlysky(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 21,
+    };
+
+    RFProtocolFlysky(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolFlysky() { close(); }
 
 // for protocol
@@ -34,9 +37,12 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
 
 private:
     int  init1(void);
+    int  calibrate(void);
     void updateCRC(void);
     void buildBindPacket(u8 state);
     void buildPacket(u8 init);
@@ -48,6 +54,7 @@ private:
     u32  mPacketCtr;
     u16  mBindCtr;
     u8   mPacketBuf[MAX_PACKET_SIZE];
+    u16  mChanVals[8];      // encoded channels in AETR order
     u8   mCurRFChanRow;
     u8   mCurRFChanCol;
     u8   mRFChanOffset;
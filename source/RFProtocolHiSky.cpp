@@ -15,6 +15,8 @@
 
 #include <SPI.h>
 #include "RFProtocolHiSky.h"
+#include "ChanScale.h"
+#include "HiSkyHop.h"
 #include "utils.h"
 
 #define MAX_BIND_COUNT     800
@@ -27,42 +29,6 @@ enum {
 };
 
 
-void RFProtocolHiSky::buildRFChannels(u32 seed)
-{
-    int idx = 0;
-    u32 rnd = seed;
-    while (idx < MAX_RF_CHANNELS) {
-        int i;
-        int count_2_26 = 0, count_27_50 = 0, count_51_74 = 0;
-        rnd = rnd * 0x0019660D + 0x3C6EF35F; // Randomization
-
-        // Use least-significant byte. 73 is prime, so channels 76..77 are unused
-        u8 next_ch = ((rnd >> 8) % 73) + 2;
-        // Keep the distance 2 between the channels - either odd or even
-        if (((next_ch ^ seed) & 0x01 )== 0)
-            continue;
-        // Check that it's not duplicate and spread uniformly
-        for (i = 0; i < idx; i++) {
-            if(mRFChanBufs[i] == next_ch)
-                break;
-            if(mRFChanBufs[i] <= 26)
-                count_2_26++;
-            else if (mRFChanBufs[i] <= 50)
-                count_27_50++;
-            else
-                count_51_74++;
-        }
-        if (i != idx)
-            continue;
-        if ((next_ch <= 26 && count_2_26 < 8)
-          ||(next_ch >= 27 && next_ch <= 50 && count_27_50 < 8)
-          ||(next_ch >= 51 && count_51_74 < 8))
-        {
-            mRFChanBufs[idx++] = next_ch;
-        }
-    }
-}
-
 void RFProtocolHiSky::buildBindingPacket(void)
 {
     u8 i;
@@ -102,7 +68,7 @@ void RFProtocolHiSky::buildBindingPacket(void)
 
 u16 RFProtocolHiSky::getChannel(u8 id)
 {
-    u16 ret = (s32)RFProtocol::getControl(id) * 450 / CHAN_MAX_VALUE + 500; // max/min servo range is +-125%
+    u16 ret = ChanScale<450>::scale(RFProtocol::getControl(id)) + 500; // max/min servo range is +-125%
     if (id == CH_THROTTLE)
         ret = 1000 - ret;
     else if (id == CH_AUX3)                                                 // Channel 7 - Gyro mode, 0 - 6 axis, 3 - 3 axis
@@ -166,7 +132,7 @@ void RFProtocolHiSky::initRxTxAddr(void)
     // divergence round
     for (u8 i = 0; i < sizeof(lfsr); ++i) 
         rand32_r(&lfsr, 0);
-    buildRFChannels(lfsr);    
+    HiSkyHop::build(lfsr, mRFChanBufs);     // bounded draws, same time for every model
 
 }
 
@@ -215,8 +181,10 @@ u16 RFProtocolHiSky::callState(void)
             mBindCtr--;
             if (!mBindCtr) {    // binding finished, change tx add
                 mState = HISKY_DATA;
+                saveBind(mRxTxAddrBuf, sizeof(mRxTxAddrBuf));
             }
             mDev.writePayload(mBindingBufs[mBindingIdx], MAX_PACKET_SIZE);
+            mDev.startTx(getPowerMode() != POWER_ALWAYS_ON);
             mBindingIdx++;
             if (mBindingIdx >= 4)
                 mBindingIdx = 0;
@@ -250,6 +218,7 @@ u16 RFProtocolHiSky::callState(void)
     default:
         mCtr1ms = 0;
         mDev.writePayload(mPacketBuf, MAX_PACKET_SIZE);
+        mDev.startTx(getPowerMode() != POWER_ALWAYS_ON);
         break;
     }
 
@@ -265,7 +234,10 @@ int RFProtocolHiSky::init(void)
     buildBindingPacket();
     init1();
 
-    if (getProtocolOpt()) {
+    // hopping and address come from controller id, the record tells the receiver was bound
+    u8 addr[ADDR_BUF_SIZE];
+    if (getProtocolOpt() ||
+        (isResume() && loadBind(addr, sizeof(addr)) && !memcmp(addr, mRxTxAddrBuf, sizeof(addr)))) {
         mBindCtr = 0;
     } else {
         mBindCtr = MAX_BIND_COUNT;
@@ -314,3 +286,14 @@ int RFProtocolHiSky::getInfo(s8 id, u8 *data)
     return size;
 }
 
+int RFProtocolHiSky::stopBind(void)
+{
+    if (mBindCtr > 1)
+        mBindCtr = 1;
+    return 0;
+}
+
+u8 RFProtocolHiSky::getBindProgress(void)
+{
+    return calcBindProgress(mBindCtr, MAX_BIND_COUNT);
+}
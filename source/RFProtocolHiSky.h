@@ -17,17 +17,19 @@
 #define _PROTOCOL_HISKY_
 
 #include "DeviceNRF24L01.h"
+#include "HiSkyHop.h"
 #include "RFProtocol.h"
 
 class RFProtocolHiSky : public RFProtocol
 {
-
-#define MAX_PACKET_SIZE     10
-#define ADDR_BUF_SIZE        5
-#define MAX_RF_CHANNELS     20
-
 public:
-    RFProtocolHiSky(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 10,
+        ADDR_BUF_SIZE   = 5,
+        MAX_RF_CHANNELS = HISKY_HOP_CHANNELS,
+    };
+
+    RFProtocolHiSky(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolHiSky() { close(); }
 
 // for protocol
@@ -36,9 +38,13 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
+    virtual void sleep(void)        { mDev.powerDown(); }
+    virtual void wake(void)         { mDev.powerUp();   }
+    virtual void restoreRadio(void) { mDev.restore();   }
 
 private:
-    void buildRFChannels(u32 seed);
     void buildBindingPacket(void);
     void buildDataPacket(void);
     void initRxTxAddr(void);
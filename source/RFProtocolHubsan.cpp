@@ -15,10 +15,13 @@
 
 #include <SPI.h>
 #include "RFProtocolHubsan.h"
+#include "ChanScale.h"
+#include "Storage.h"
 #include "utils.h"
 
 #define PROTO_OPT_TELEMETRY     0x80
 #define PROTO_OPT_VTX(f)        (5645 + ((f) & 0x7f) * 5)
+#define RX_QUALITY_PERIOD       32
 
 #define WAIT_WRITE              0x80
 
@@ -58,36 +61,16 @@ static const PROGMEM u8 TBL_INIT_REGS[] = {
      A7105_29_RX_DEM_TEST_I,    0x47
 };
 
-int RFProtocolHubsan::init1(void)
+int RFProtocolHubsan::calibrate(void)
 {
     u8 if_calibration1;
     u8 vco_calibration0;
     u8 vco_calibration1;
-    //u8 vco_current;
-
-    mDev.writeID(0x55201041);
-
-    u8 reg, val;
-    for (u8 i = 0; i < sizeof(TBL_INIT_REGS) / 2; i++) {
-        reg = pgm_read_byte(TBL_INIT_REGS + i * 2);
-        val = pgm_read_byte(TBL_INIT_REGS + i * 2 + 1);
-        mDev.writeReg(reg, val);
-    }
-    mDev.strobe(A7105_STANDBY);
 
     //IF Filter Bank Calibration
-    mDev.writeReg(0x02, 1);
-    //vco_current =
-    mDev.readReg(0x02);
-
-    u32 ms = millis();
-    while(millis()  - ms < 500) {
-        if(! mDev.readReg(0x02))
-            break;
-    }
-    if (millis() - ms >= 500)
+    if (!mDev.calibrate(1))
         return 0;
-    
+
     if_calibration1 = mDev.readReg(A7105_22_IF_CALIB_I);
     mDev.readReg(A7105_24_VCO_CURCAL);
     if(if_calibration1 & A7105_MASK_FBCF) {
@@ -105,13 +88,7 @@ int RFProtocolHubsan::init1(void)
     //Set Channel
     mDev.writeReg(A7105_0F_CHANNEL, 0);
     //VCO Calibration
-    mDev.writeReg(0x02, 2);
-    ms = millis();
-    while(millis()  - ms < 500) {
-        if(! mDev.readReg(0x02))
-            break;
-    }
-    if (millis() - ms >= 500)
+    if (!mDev.calibrate(2))
         return 0;
 
     vco_calibration0 = mDev.readReg(A7105_25_VCO_SBCAL_I);
@@ -124,13 +101,7 @@ int RFProtocolHubsan::init1(void)
     //Set Channel
     mDev.writeReg(A7105_0F_CHANNEL, 0xa0);
     //VCO Calibration
-    mDev.writeReg(A7105_02_CALC, 2);
-    ms = millis();
-    while(millis()  - ms < 500) {
-        if(! mDev.readReg(A7105_02_CALC))
-            break;
-    }
-    if (millis() - ms >= 500)
+    if (!mDev.calibrate(2))
         return 0;
 
     vco_calibration1 = mDev.readReg(A7105_25_VCO_SBCAL_I);
@@ -138,6 +109,33 @@ int RFProtocolHubsan::init1(void)
         //Calibration failed...what do we do?
     }
 
+    return 1;
+}
+
+int RFProtocolHubsan::init1(void)
+{
+    u8 cal[A7105_CALIB_SIZE];
+    u32 key = getModule();                  // same record as Flysky
+
+    mDev.writeID(0x55201041);
+
+    u8 reg, val;
+    for (u8 i = 0; i < sizeof(TBL_INIT_REGS) / 2; i++) {
+        reg = pgm_read_byte(TBL_INIT_REGS + i * 2);
+        val = pgm_read_byte(TBL_INIT_REGS + i * 2 + 1);
+        mDev.writeReg(reg, val);
+    }
+    mDev.strobe(A7105_STANDBY);
+
+    // reuse the last good calibration, run the full one only if it is refused
+    if (Storage::read(Storage::SLOT_A7105_CALIB, key, cal, sizeof(cal)) < 0 || !mDev.setCalibration(cal)) {
+        if (!calibrate())
+            return 0;
+        mDev.getCalibration(cal);
+        if (mDev.setCalibration(cal))
+            Storage::write(Storage::SLOT_A7105_CALIB, key, cal, sizeof(cal));
+    }
+
     //Reset VCO Band calibration
     //mDev.writeReg(0x25, 0x08);
     mDev.setTxRxMode(TX_EN);
@@ -157,6 +155,7 @@ void RFProtocolHubsan::updateCRC(void)
 
 void RFProtocolHubsan::buildBindPacket(u8 state)
 {
+    mPacketValid = 0;
     mPacketBuf[0] = state;
     mPacketBuf[1] = mCurRFChan;
     mPacketBuf[2] = (mSessionID >> 24) & 0xff;
@@ -175,61 +174,79 @@ void RFProtocolHubsan::buildBindPacket(u8 state)
     updateCRC();
 }
 
-s16 RFProtocolHubsan::getChannel(u8 ch, s32 scale, s32 center, s32 range)
+// 0x00 ~ 0xff, center 0x80
+u8 RFProtocolHubsan::getChannel(u8 ch)
 {
-    s32 value = (s32)RFProtocol::getControl(ch) * scale / CHAN_MAX_VALUE + center;
-
-    if (value < center - range)
-        value = center - range;
-    if (value >= center + range)
-        value = center + range -1;
+    return clamp(ChanScale<0x80>::scale(RFProtocol::getControl(ch)) + 0x80, 0, 0xff);
+}
 
-    return value;
+// keeps the checksum in step with the changed byte
+void RFProtocolHubsan::setPacketByte(u8 idx, u8 val)
+{
+    mPacketSum += val - mPacketBuf[idx];
+    mPacketBuf[idx] = val;
 }
 
+// the last data packet is kept, only changed sticks are scaled again
 void RFProtocolHubsan::buildPacket(void)
 {
-    static s16 vtx_freq = 0;
-    
-    memset(mPacketBuf, 0, MAX_PACKET_SIZE);
+    u16 dirty = fetchDirty();
+    u8  flags;
+    u8  vtx;
 
     // set vTX frequency (H107D)
-    if(vtx_freq != PROTO_OPT_VTX(getProtocolOpt()) || mPacketCtr == 100) {
-        vtx_freq = PROTO_OPT_VTX(getProtocolOpt());
-        mPacketBuf[0] = 0x40;
-        mPacketBuf[1] = (vtx_freq >> 8) & 0xff;
-        mPacketBuf[2] = vtx_freq & 0xff;
-        mPacketBuf[3] = 0x82;
-        mPacketCtr++;      
-    } else {                                                            //20 00 00 00 80 00 7d 00 84 02 64 db 04 26 79 7b
-        mPacketBuf[0] = 0x20;
-        mPacketBuf[2] = getChannel(CH_THROTTLE, 0x80, 0x80, 0x80);      //Throttle
+    vtx = (mVtxFreq != PROTO_OPT_VTX(getProtocolOpt()) || mPacketCtr == 100);
+    if (vtx || !mPacketValid) {
+        memset(mPacketBuf, 0, MAX_PACKET_SIZE);
+        if (vtx) {
+            mVtxFreq = PROTO_OPT_VTX(getProtocolOpt());
+            mPacketBuf[0] = 0x40;
+            mPacketBuf[1] = (mVtxFreq >> 8) & 0xff;
+            mPacketBuf[2] = mVtxFreq & 0xff;
+            mPacketBuf[3] = 0x82;
+            mPacketCtr++;
+        } else {                                                        //20 00 00 00 80 00 7d 00 84 02 64 db 04 26 79 7b
+            mPacketBuf[0] = 0x20;
+        }
+        mPacketBuf[10] = 0x64;
+        mPacketBuf[11] = (mTXID >> 24) & 0xff;
+        mPacketBuf[12] = (mTXID >> 16) & 0xff;
+        mPacketBuf[13] = (mTXID >>  8) & 0xff;
+        mPacketBuf[14] = (mTXID >>  0) & 0xff;
+
+        mPacketSum = 0;
+        for (u8 i = 0; i < MAX_PACKET_SIZE - 1; i++)
+            mPacketSum += mPacketBuf[i];
+        mPacketValid = !vtx;
+        dirty = 0xffff;
     }
-    mPacketBuf[4] = 0xff - getChannel(CH_RUDDER, 0x80, 0x80, 0x80);     //Rudder is reversed
-    mPacketBuf[6] = 0xff - getChannel(CH_ELEVATOR, 0x80, 0x80, 0x80);   //Elevator is reversed
-    mPacketBuf[8] = getChannel(CH_AILERON, 0x80, 0x80, 0x80);           //Aileron 
+
+    if (!vtx && (dirty & BV(CH_THROTTLE)))
+        setPacketByte(2, getChannel(CH_THROTTLE));         //Throttle
+    if (dirty & BV(CH_RUDDER))
+        setPacketByte(4, 0xff - getChannel(CH_RUDDER));    //Rudder is reversed
+    if (dirty & BV(CH_ELEVATOR))
+        setPacketByte(6, 0xff - getChannel(CH_ELEVATOR));  //Elevator is reversed
+    if (dirty & BV(CH_AILERON))
+        setPacketByte(8, getChannel(CH_AILERON));          //Aileron
 
     if(mPacketCtr < 100) {
-        mPacketBuf[9] = 0x02 | FLAG_LED | FLAG_FLIP;                    // sends default value for the 100 first packets
+        flags = 0x02 | FLAG_LED | FLAG_FLIP;                            // sends default value for the 100 first packets
         mPacketCtr++;
     } else {
-        mPacketBuf[9] = 0x02;
+        flags = 0x02;
 
         if(getControl(CH_AUX1) >= 0)
-            mPacketBuf[9] |= FLAG_LED;
+            flags |= FLAG_LED;
 
         if(getControl(CH_AUX2) >= 0)
-            mPacketBuf[9] |= FLAG_FLIP;
+            flags |= FLAG_FLIP;
 
         if(getControl(CH_AUX3) > 0)                                     // off by default
-            mPacketBuf[9] |= FLAG_VIDEO;
+            flags |= FLAG_VIDEO;
     }
-    mPacketBuf[10] = 0x64;
-    mPacketBuf[11] = (mTXID >> 24) & 0xff;
-    mPacketBuf[12] = (mTXID >> 16) & 0xff;
-    mPacketBuf[13] = (mTXID >>  8) & 0xff;
-    mPacketBuf[14] = (mTXID >>  0) & 0xff;
-    updateCRC();
+    setPacketByte(9, flags);
+    mPacketBuf[MAX_PACKET_SIZE - 1] = -mPacketSum;
 }
 
 u8 RFProtocolHubsan::checkIntegrity(void) 
@@ -240,6 +257,59 @@ u8 RFProtocolHubsan::checkIntegrity(void)
     return mPacketBuf[MAX_PACKET_SIZE - 1] == ((256 - (sum % 256)) & 0xff);
 }
 
+// 0xe1, 0xe7 frames from the quad, battery in 1/10 V
+void RFProtocolHubsan::updateTelemetry(void)
+{
+    if ((mPacketBuf[0] != 0xe1 && mPacketBuf[0] != 0xe7) || !checkIntegrity())
+        return;
+
+    mTelemetry.volt[0] = mPacketBuf[13];
+    mTelemetry.rssi    = mDev.readReg(A7105_1D_RSSI_THOLD);
+    mTelemetry.updated |= TELEM_VOLT;
+    mRxFrames++;
+}
+
+// quality is the % of 10ms slots with a valid frame over the last RX_QUALITY_PERIOD slots
+void RFProtocolHubsan::updateLinkQuality(void)
+{
+    if (++mRxWindows == RX_QUALITY_PERIOD) {
+        if (mRxFrames > RX_QUALITY_PERIOD)
+            mRxFrames = RX_QUALITY_PERIOD;
+        mTelemetry.quality = ((u16)mRxFrames * 100) / RX_QUALITY_PERIOD;
+        mTelemetry.updated |= TELEM_LINK;
+        mRxWindows = 0;
+        mRxFrames  = 0;
+    }
+}
+
+typedef struct {
+    u32  sessionID;
+    u32  radioID;
+    u8   rfChan;
+} BIND_T;
+
+bool RFProtocolHubsan::loadBindData(void)
+{
+    BIND_T bind;
+
+    if (!loadBind(&bind, sizeof(bind)))
+        return false;
+    mSessionID = bind.sessionID;
+    mRadioID   = bind.radioID;
+    mCurRFChan = bind.rfChan;
+    return true;
+}
+
+void RFProtocolHubsan::saveBindData(void)
+{
+    BIND_T bind;
+
+    bind.sessionID = mSessionID;
+    bind.radioID   = mRadioID;
+    bind.rfChan    = mCurRFChan;
+    saveBind(&bind, sizeof(bind));
+}
+
 u16 RFProtocolHubsan::callState(void)
 {
     static u16 delay = 0;
@@ -285,11 +355,12 @@ u16 RFProtocolHubsan::callState(void)
                 return 4500;                        //No signal, restart binding procedure.  12msec elapsed since last write
             }
             
-            mDev.readData(mPacketBuf, MAX_PACKET_SIZE);
+            mDev.readFIFO(mPacketBuf, MAX_PACKET_SIZE);
+            mPacketValid = 0;
             mState++;
             if (mState == BIND_5) {
-                u32 id = ((u32)mPacketBuf[2] << 24) | ((u32)mPacketBuf[3] << 16) | ((u32)mPacketBuf[4] << 8) | mPacketBuf[5];
-                mDev.writeID(id);
+                mRadioID = ((u32)mPacketBuf[2] << 24) | ((u32)mPacketBuf[3] << 16) | ((u32)mPacketBuf[4] << 8) | mPacketBuf[5];
+                mDev.writeID(mRadioID);
             }
             
             return 500;                             //8msec elapsed time since last write;
@@ -300,10 +371,12 @@ u16 RFProtocolHubsan::callState(void)
                 mState = BIND_7;
                 return 15000;                       //22.5msec elapsed since last write
             }
-            mDev.readData(mPacketBuf, MAX_PACKET_SIZE);
+            mDev.readFIFO(mPacketBuf, MAX_PACKET_SIZE);
+            mPacketValid = 0;
             if (mPacketBuf[1] == 9) {
                 mState = DATA_1;
                 mDev.writeReg(A7105_1F_CODE_I, 0x0F);
+                saveBindData();
                 return 28000;                       //35.5msec elapsed since last write
             } else {
                 mState = BIND_7;
@@ -344,8 +417,9 @@ u16 RFProtocolHubsan::callState(void)
                     if (rfMode == A7105_RX) {                           // check for telemetry frame
                         for (i = 0; i < 10; i++) {
                             if (!(mDev.readReg(A7105_00_MODE) & 0x01)) {// data received
-                                mDev.readData(mPacketBuf, 16);
-                                //updateTelemetry();
+                                mDev.readFIFO(mPacketBuf, MAX_PACKET_SIZE);
+                                mPacketValid = 0;
+                                updateTelemetry();
                                 mDev.strobe(A7105_RX);
                                 break;
                             }
@@ -356,6 +430,8 @@ u16 RFProtocolHubsan::callState(void)
             }
             
             if (++txState == 8) { // 3ms + 7 * 1ms = 10ms
+                if (getProtocolOpt() & PROTO_OPT_TELEMETRY)
+                    updateLinkQuality();
                 mDev.setTxRxMode(TX_EN);
                 txState = 0;
             }
@@ -371,17 +447,29 @@ int RFProtocolHubsan::init(void)
 {
     mTXID = 0xdb042679; // getControllerID();
 
+    mDev.initialize();
     while(1) {
         mDev.reset();
         if (init1())
             break;
     }
 
-    mSessionID = getControllerID();
-    mSessionID = rand32_r(&mSessionID, 0);
-    mCurRFChan = pgm_read_byte(ALLOWED_CH + (mSessionID % sizeof(ALLOWED_CH)));
     mPacketCtr = 0;
-    mState     = BIND_1;
+    mPacketValid = 0;
+    mVtxFreq = 0;
+    if (isResume() && loadBindData()) {
+        mDev.writeID(mRadioID);
+        mDev.writeReg(A7105_1F_CODE_I, 0x0F);
+        mState = DATA_1;
+    } else {
+        mSessionID = getControllerID();
+        mSessionID = rand32_r(&mSessionID, 0);
+        mCurRFChan = pgm_read_byte(ALLOWED_CH + (mSessionID % sizeof(ALLOWED_CH)));
+        mState     = BIND_1;
+    }
+    memset(&mTelemetry, 0, sizeof(mTelemetry));
+    mRxWindows = 0;
+    mRxFrames  = 0;
 
     startState(INITIAL_WAIT_uS);
 
@@ -428,3 +516,17 @@ int RFProtocolHubsan::getInfo(s8 id, u8 *data)
     return size;
 }
 
+// binding is a handshake with the quad, it can not be cut short
+int RFProtocolHubsan::stopBind(void)
+{
+    return ((mState & ~WAIT_WRITE) >= DATA_1) ? 0 : -1;
+}
+
+u8 RFProtocolHubsan::getBindProgress(void)
+{
+    u8 state = mState & ~WAIT_WRITE;
+
+    if (state >= DATA_1)
+        return 100;
+    return (state - BIND_1) * 100 / (DATA_1 - BIND_1);
+}
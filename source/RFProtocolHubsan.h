@@ -22,11 +22,14 @@
 
 class RFProtocolHubsan : public RFProtocol
 {
-#define MAX_PACKET_SIZE         16
-#define INITIAL_WAIT_uS         10000
 
 public:
-    RFProtocolHubsan(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 16,
+        INITIAL_WAIT_uS = 10000,
+    };
+
+    RFProtocolHubsan(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolHubsan() { close(); }
 
 // for protocol
@@ -35,26 +38,43 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
+    virtual TELEMETRY_T *getTelemetry(void) { return &mTelemetry; }
 
 private:
     int  init1(void);
+    int  calibrate(void);
     void updateCRC(void);
     void buildBindPacket(u8 state);
     void buildPacket(void);
-    s16  getChannel(u8 ch, s32 scale, s32 center, s32 range);
+    void setPacketByte(u8 idx, u8 val);
+    u8   getChannel(u8 ch);
     u8   checkIntegrity(void);
+    void updateTelemetry(void);
+    void updateLinkQuality(void);
+    bool loadBindData(void);
+    void saveBindData(void);
 
 // variables
     DeviceA7105  mDev;
     u32  mSessionID;
     u32  mTXID;
+    u32  mRadioID;      // id the quad answered while binding
     u16  mBindCtr;
+    s16  mVtxFreq;      // vTX frequency last sent to the quad
     u8   mPacketBuf[MAX_PACKET_SIZE];
+    u8   mPacketSum;    // sum of data packet bytes without checksum
+    u8   mPacketValid;  // mPacketBuf holds the last data packet
     u8   mCurRFChan;
 
     u8   mPacketCtr;    
     u8   mState;
-    
+
+    TELEMETRY_T mTelemetry;
+    u8   mRxWindows;        // 10ms slots in the current quality period
+    u8   mRxFrames;         // valid frames in the current quality period
+
 protected:
 
 };
@@ -15,6 +15,7 @@
 
 #include <SPI.h>
 #include "RFProtocolSyma.h"
+#include "ChanScale.h"
 #include "utils.h"
 
 #define PAYLOADSIZE         10  // receive data pipes set to this size, but unused
@@ -63,27 +64,34 @@ u8 RFProtocolSyma::checkStatus()
 #define BABS(X) (((X) < 0) ? -(u8)(X) : (X))
 u8 RFProtocolSyma::getChannel(u8 id)
 {
-    s32 ch = RFProtocol::getControl(id);
-    if (ch < CHAN_MIN_VALUE) {
-        ch = CHAN_MIN_VALUE;
-    } else if (ch > CHAN_MAX_VALUE) {
-        ch = CHAN_MAX_VALUE;
-    }
+    s16 ch = clamp(RFProtocol::getControl(id), CHAN_MIN_VALUE, CHAN_MAX_VALUE);
 
-    u8 ret = (u8) ((ch < 0 ? 0x80 : 0) | BABS(ch * 127 / CHAN_MAX_VALUE));
+    u8 ret = (u8) ((ch < 0 ? 0x80 : 0) | BABS(ChanScale<127>::scale(ch)));
     return ret;
 }
 
+// scaled sticks are cached, returns the controls changed since the last data packet
+u16 RFProtocolSyma::updateChannels(void)
+{
+    u16 dirty = fetchDirty();
+
+    for (u8 i = CH_THROTTLE; i <= CH_AILERON; i++) {
+        if (dirty & BV(i))
+            mChanVals[i] = getChannel(i);
+    }
+    return dirty;
+}
+
 void RFProtocolSyma::getControls(u8* throttle, u8* rudder, u8* elevator, u8* aileron, u8* flags)
 {
     // Protocol is registered AETRF, that is
     // Aileron is channel 1, Elevator - 2, Throttle - 3, Rudder - 4, Flip control - 5
 
-    *aileron  = getChannel(CH_AILERON);
-    *elevator = getChannel(CH_ELEVATOR);
-    *throttle = getChannel(CH_THROTTLE);
+    *aileron  = mChanVals[CH_AILERON];
+    *elevator = mChanVals[CH_ELEVATOR];
+    *throttle = mChanVals[CH_THROTTLE];
     *throttle = (*throttle & 0x80) ? (0xff - *throttle) : (0x80 + *throttle);
-    *rudder   = getChannel(CH_RUDDER);
+    *rudder   = mChanVals[CH_RUDDER];
 
     // Channel 5
     if (RFProtocol::getControl(CH_AUX1) <= 0)
@@ -116,17 +124,20 @@ void RFProtocolSyma::buildPacketX5C(u8 bind)
     u8 flag;
 
     if (bind) {
+        mPacketValid = 0;
         memset(mPacketBuf, 0, mPacketSize);
         mPacketBuf[7] = 0xae;
         mPacketBuf[8] = 0xa9;
         mPacketBuf[14] = 0xc0;
         mPacketBuf[15] = 0x17;
     } else {
+        if (!updateChannels() && mPacketValid)
+            return;
         getControls(&mPacketBuf[0], &mPacketBuf[1], &mPacketBuf[2], &mPacketBuf[3], &flag);
         mPacketBuf[2] ^= 0x80;  // reversed from default
-        mPacketBuf[4] = X5C_CHAN2TRIM(getChannel(CH_RUDDER) ^ 0x80);     // drive trims for extra control range
-        mPacketBuf[5] = X5C_CHAN2TRIM(getChannel(CH_ELEVATOR));
-        mPacketBuf[6] = X5C_CHAN2TRIM(getChannel(CH_AILERON) ^ 0x80);
+        mPacketBuf[4] = X5C_CHAN2TRIM(mChanVals[CH_RUDDER] ^ 0x80);     // drive trims for extra control range
+        mPacketBuf[5] = X5C_CHAN2TRIM(mChanVals[CH_ELEVATOR]);
+        mPacketBuf[6] = X5C_CHAN2TRIM(mChanVals[CH_AILERON] ^ 0x80);
         mPacketBuf[7] = 0xae;
         mPacketBuf[8] = 0xa9;
         mPacketBuf[9] = 0x00;
@@ -139,6 +150,7 @@ void RFProtocolSyma::buildPacketX5C(u8 bind)
                        | ((flag & FLAG_FLIP)    ? 0x01 : 0x00)
                        | 0x04;  // always high rates (bit 3 is rate control)
         mPacketBuf[15] = getCheckSum(mPacketBuf);
+        mPacketValid = 1;
     }
 }
 
@@ -147,6 +159,7 @@ void RFProtocolSyma::buildPacket(u8 bind)
     u8 flag;
 
     if (bind) {
+        mPacketValid = 0;
         mPacketBuf[0] = mRxTxAddrBuf[4];
         mPacketBuf[1] = mRxTxAddrBuf[3];
         mPacketBuf[2] = mRxTxAddrBuf[2];
@@ -157,14 +170,17 @@ void RFProtocolSyma::buildPacket(u8 bind)
         mPacketBuf[7] = 0xaa;
         mPacketBuf[8] = 0x00;
     } else {
+        if (!updateChannels() && mPacketValid)
+            return;
         getControls(&mPacketBuf[0], &mPacketBuf[2], &mPacketBuf[1], &mPacketBuf[3], &flag);
         mPacketBuf[4] = ((flag & FLAG_VIDEO)   ? 0x80 : 0x00)
                       | ((flag & FLAG_PICTURE) ? 0x40 : 0x00);
         // use trims to extend controls
-        mPacketBuf[5] = (getChannel(CH_ELEVATOR) >> 2) | 0xc0; // always high rates (bit 7 is rate control)
-        mPacketBuf[6] = (getChannel(CH_RUDDER) >> 2)   | ((flag & FLAG_FLIP) ? 0x40 : 0x00);
-        mPacketBuf[7] = getChannel(CH_AILERON) >> 2    | ((flag & FLAG_HEADLESS) ? 0x80 : 0x00);
+        mPacketBuf[5] = (mChanVals[CH_ELEVATOR] >> 2) | 0xc0; // always high rates (bit 7 is rate control)
+        mPacketBuf[6] = (mChanVals[CH_RUDDER] >> 2)   | ((flag & FLAG_FLIP) ? 0x40 : 0x00);
+        mPacketBuf[7] = mChanVals[CH_AILERON] >> 2    | ((flag & FLAG_HEADLESS) ? 0x80 : 0x00);
         mPacketBuf[8] = 0x00;
+        mPacketValid = 1;
     }
     mPacketBuf[9] = getCheckSum(mPacketBuf);
 
@@ -191,12 +207,10 @@ void RFProtocolSyma::sendPacket(u8 bind)
 
 //    printf(F("SEND PACKET bind:%d :%d\n"), bind, mPacketCtr);
 
-//    radio.ce(HIGH);
-//    delayMicroseconds(15);
     // It saves power to turn off radio after the transmission,
     // so as long as we have pins to do so, it is wise to turn
     // it back.
-//    radio.ce(LOW);
+    mDev.startTx(getPowerMode() != POWER_ALWAYS_ON);
 
 
     // Check and adjust transmission power. We do this after
@@ -391,6 +405,7 @@ u16 RFProtocolSyma::callState(void)
     case SYMAX_BIND3:
         if (mBindCtr == 0) {
             init3();
+            saveBind(mRxTxAddrBuf, sizeof(mRxTxAddrBuf));
             mState = SYMAX_DATA;
         } else {
             sendPacket(1);
@@ -408,9 +423,15 @@ u16 RFProtocolSyma::callState(void)
 int RFProtocolSyma::init(void)
 {
     mPacketCtr = 0;
+    mPacketValid = 0;
 
     init1();
-    mState = SYMAX_INIT1;
+    if (isResume() && loadBind(mRxTxAddrBuf, sizeof(mRxTxAddrBuf))) {
+        init3();
+        mState = SYMAX_DATA;
+    } else {
+        mState = SYMAX_INIT1;
+    }
 
     startState(INITIAL_WAIT_uS);
 
@@ -456,3 +477,18 @@ int RFProtocolSyma::getInfo(s8 id, u8 *data)
     return size;
 }
 
+int RFProtocolSyma::stopBind(void)
+{
+    if (mState == SYMAX_BIND3)
+        mBindCtr = 0;
+    else if (mState != SYMAX_DATA)
+        return -1;
+    return 0;
+}
+
+u8 RFProtocolSyma::getBindProgress(void)
+{
+    if (mState == SYMAX_BIND3)
+        return calcBindProgress(mBindCtr, MAX_BIND_COUNT);
+    return (mState == SYMAX_DATA) ? 100 : 0;
+}
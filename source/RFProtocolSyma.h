@@ -22,12 +22,15 @@
 
 class RFProtocolSyma : public RFProtocol
 {
-#define MAX_PACKET_SIZE     16  // X11,X12,X5C-1 10-byte, X5C 16-byte
-#define ADDR_BUF_SIZE        5
-#define MAX_RF_CHANNELS     17
 
 public:
-    RFProtocolSyma(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 16,               // X11,X12,X5C-1 10-byte, X5C 16-byte
+        ADDR_BUF_SIZE   = 5,
+        MAX_RF_CHANNELS = 17,
+    };
+
+    RFProtocolSyma(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolSyma() { close(); }
 
 // for protocol
@@ -36,11 +39,17 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
+    virtual void sleep(void)        { mDev.powerDown(); }
+    virtual void wake(void)         { mDev.powerUp();   }
+    virtual void restoreRadio(void) { mDev.restore();   }
 
 private:
     u8   getCheckSum(u8 *data);
     u8   checkStatus(void);
     u8   getChannel(u8 id);
+    u16  updateChannels(void);
     void getControls(u8* throttle, u8* rudder, u8* elevator, u8* aileron, u8* flags);
     void buildPacketX5C(u8 bind);
     void buildPacket(u8 bind);
@@ -58,6 +67,8 @@ private:
     u8   mRFChanBufs[MAX_RF_CHANNELS];
     u8   mPacketBuf[MAX_PACKET_SIZE];
     u8   mRxTxAddrBuf[ADDR_BUF_SIZE];
+    u8   mChanVals[4];      // scaled throttle, rudder, elevator, aileron
+    u8   mPacketValid;      // mPacketBuf holds the last data packet
     
     u8   mCurRFChan;
     u8   mRFChanCnt;
@@ -15,6 +15,7 @@
 
 #include <SPI.h>
 #include "RFProtocolV2x2.h"
+#include "ChanScale.h"
 #include "utils.h"
 
 #define MAX_BIND_COUNT    1000
@@ -93,14 +94,9 @@ u8 RFProtocolV2x2::checkStatus()
 
 u8 RFProtocolV2x2::getChannel(u8 id)
 {
-    s32 ch = RFProtocol::getControl(id);
-    if (ch < CHAN_MIN_VALUE) {
-        ch = CHAN_MIN_VALUE;
-    } else if (ch > CHAN_MAX_VALUE) {
-        ch = CHAN_MAX_VALUE;
-    }
+    s16 ch = clamp(RFProtocol::getControl(id), CHAN_MIN_VALUE, CHAN_MAX_VALUE);
 
-    u8 ret =  (u8) (((ch * 0xFF / CHAN_MAX_VALUE) + 0x100) >> 1);
+    u8 ret =  (u8) ((ChanScale<0xFF>::scale(ch) + 0x100) >> 1);
     return ret;
 }
 
@@ -140,7 +136,7 @@ void RFProtocolV2x2::getControls(u8* throttle, u8* rudder, u8* elevator, u8* ail
         if (getProtocolOpt() & PROTO_OPT_BLINK) {
 #endif
             nNewLedBlinkCtr = (BLINK_COUNT_MAX + BLINK_COUNT_MIN) / 2 -
-                ((s32) RFProtocol::getControl(CH_AUX1) * (BLINK_COUNT_MAX - BLINK_COUNT_MIN) / (2 * CHAN_MAX_VALUE));
+                ChanScale<BLINK_COUNT_MAX - BLINK_COUNT_MIN, 2 * CHAN_MAX_VALUE>::scale(RFProtocol::getControl(CH_AUX1));
 #if defined(USE_BLINK_OPTION)
         } else {
             nNewLedBlinkCtr = (ch <= 0) ? BLINK_COUNT_MAX + 1 : BLINK_COUNT_MAX - 1;
@@ -239,12 +235,10 @@ void RFProtocolV2x2::sendPacket(u8 bind)
     ++mPacketCtr;
     mPacketSent = 1;
 
-//    radio.ce(HIGH);
-//    delayMicroseconds(15);
     // It saves power to turn off radio after the transmission,
     // so as long as we have pins to do so, it is wise to turn
     // it back.
-//    radio.ce(LOW);
+    mDev.startTx(getPowerMode() != POWER_ALWAYS_ON);
 
     // Check and adjust transmission power. We do this after
     // transmission to not bother with timeout after power
@@ -288,12 +282,12 @@ static const PROGMEM u8 TBL_INIT_REGS[] = {
     0xC5,                                           // 0E :
     0xC6,                                           // 0F :
     0xff,                                           // 10 : skip
-    MAX_PACKET_SIZE,                                // 11 : bytes of data payload for pipe 1
-    MAX_PACKET_SIZE,                                // 12 :
-    MAX_PACKET_SIZE,                                // 13 :
-    MAX_PACKET_SIZE,                                // 14 :
-    MAX_PACKET_SIZE,                                // 15 :
-    MAX_PACKET_SIZE,                                // 16 :
+    RFProtocolV2x2::MAX_PACKET_SIZE,                // 11 : bytes of data payload for pipe 1
+    RFProtocolV2x2::MAX_PACKET_SIZE,                // 12 :
+    RFProtocolV2x2::MAX_PACKET_SIZE,                // 13 :
+    RFProtocolV2x2::MAX_PACKET_SIZE,                // 14 :
+    RFProtocolV2x2::MAX_PACKET_SIZE,                // 15 :
+    RFProtocolV2x2::MAX_PACKET_SIZE,                // 16 :
     0x00                                            // 17 : Just in case, no real bits to write here
 };
 
@@ -361,7 +355,7 @@ void RFProtocolV2x2::setTxID(u32 id)
     u8 increment = (sum & 0x1e) >> 2;                   // Higher 3 bits define increment to corresponding row
     
     for (u8 i = 0; i < 16; ++i) {
-        u8 val = pgm_read_byte(fh_row[i] + increment);
+        u8 val = pgm_read_byte(fh_row + i) + increment;
         mRFChanBufs[i] = (val & 0x0f) ? val : val - 3;  // Strange avoidance of channels divisible by 16
     }
 }
@@ -394,6 +388,7 @@ u16 RFProtocolV2x2::callState(void)
             mState = V202_DATA;
             mBindCtr = mLedBlinkCtr;
             mAuxFlag = 0;
+            saveBind(mRxTxAddrBuf, sizeof(mRxTxAddrBuf));
         }
         break;
 
@@ -422,14 +417,18 @@ int RFProtocolV2x2::init(void)
     mLedBlinkCtr = BLINK_COUNT_MAX;
 
     init1();
-    if (getProtocolOpt() == PROTO_OPT_SKIP_BIND) {
+    initRxTxAddr();
+
+    // address and hopping come from controller id, the record tells the receiver was bound
+    u8 addr[ADDR_BUF_SIZE];
+    if (getProtocolOpt() == PROTO_OPT_SKIP_BIND ||
+        (isResume() && loadBind(addr, sizeof(addr)) && !memcmp(addr, mRxTxAddrBuf, sizeof(addr)))) {
         mState   = V202_INIT2_NO_BIND;
         mBindCtr = BLINK_COUNT;
     } else {
         mState   = V202_INIT2;
         mBindCtr = MAX_BIND_COUNT;
     }
-    initRxTxAddr();
     startState(INITIAL_WAIT_uS);
 
     return 0;
@@ -473,3 +472,22 @@ int RFProtocolV2x2::getInfo(s8 id, u8 *data)
     return size;
 }
 
+int RFProtocolV2x2::stopBind(void)
+{
+    if (mState == V202_BIND1 || mState == V202_BIND2) {
+        mState   = V202_DATA;
+        mBindCtr = mLedBlinkCtr;
+        mAuxFlag = 0;
+        saveBind(mRxTxAddrBuf, sizeof(mRxTxAddrBuf));
+    } else if (mState != V202_DATA) {
+        return -1;
+    }
+    return 0;
+}
+
+u8 RFProtocolV2x2::getBindProgress(void)
+{
+    if (mState == V202_BIND2)
+        return calcBindProgress(mBindCtr, MAX_BIND_COUNT);
+    return (mState == V202_DATA) ? 100 : 0;
+}
@@ -22,12 +22,14 @@
 class RFProtocolV2x2 : public RFProtocol
 {
 
-#define MAX_PACKET_SIZE     16
-#define ADDR_BUF_SIZE        3
-#define MAX_RF_CHANNELS     17
-
 public:
-    RFProtocolV2x2(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 16,
+        ADDR_BUF_SIZE   = 3,
+        MAX_RF_CHANNELS = 17,
+    };
+
+    RFProtocolV2x2(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolV2x2() { close(); }
 
 // for protocol
@@ -36,6 +38,10 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
+    virtual void sleep(void)        { mDev.powerDown(); }
+    virtual void wake(void)         { mDev.powerUp();   }
 
 private:
     u8   getCheckSum(u8 *data);
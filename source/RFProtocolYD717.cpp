@@ -15,6 +15,7 @@
 
 #include <SPI.h>
 #include "RFProtocolYD717.h"
+#include "ChanScale.h"
 #include "utils.h"
 
 
@@ -25,6 +26,7 @@
 
 // Stock tx fixed frequency is 0x3C. Receiver only binds on this freq.
 #define RF_CHANNEL          0x3C
+#define RETR_MAX_COUNT      9       // (9 + 1) * (500us + 280us air time and PLL settle) = 7.8ms within PACKET_PERIOD_uS
 
 #define FLAG_FLIP           0x0F
 #define FLAG_LIGHT          0x80
@@ -71,14 +73,9 @@ u8 RFProtocolYD717::checkStatus()
 
 u8 RFProtocolYD717::getControl(u8 id)
 {
-    s32 ch = RFProtocol::getControl(id);
-    if (ch < CHAN_MIN_VALUE) {
-        ch = CHAN_MIN_VALUE;
-    } else if (ch > CHAN_MAX_VALUE) {
-        ch = CHAN_MAX_VALUE;
-    }
+    s16 ch = clamp(RFProtocol::getControl(id), CHAN_MIN_VALUE, CHAN_MAX_VALUE);
 
-    u8 ret = (u8) (((ch * 0xFF / CHAN_MAX_VALUE) + 0x100) >> 1);
+    u8 ret = (u8) ((ChanScale<0xFF>::scale(ch) + 0x100) >> 1);
     return ret;
 }
 
@@ -170,12 +167,10 @@ void RFProtocolYD717::sendPacket(u8 bind)
     }
     ++mPacketCtr;
 
-//    radio.ce(HIGH);
-//    delayMicroseconds(15);
     // It saves power to turn off radio after the transmission,
     // so as long as we have pins to do so, it is wise to turn
     // it back.
-//    radio.ce(LOW);
+    mDev.startTx(getPowerMode() != POWER_ALWAYS_ON);
 
     // Check and adjust transmission power. We do this after
     // transmission to not bother with timeout after power
@@ -208,7 +203,7 @@ static const PROGMEM u8 TBL_INIT_REGS[] = {
     0x3F,                                           // 01 : Auto Acknoledgement on all data pipes
     0x3F,                                           // 02 : Enable all data pipes (even though not used?)
     0x03,                                           // 03 : 5-byte RX/TX address
-    0x1A,                                           // 04 : 500uS retransmit t/o, 10 tries
+    0xff,                                           // 04 : skip, set by setRetransmit()
     RF_CHANNEL,                                     // 05 : RF channel : 3C
     0xff,                                           // 06 : skip
     0x70,                                           // 07 : Clear data ready, data sent, and retransmit
@@ -247,7 +242,8 @@ void RFProtocolYD717::init1(void)
         }
     }
     mDev.writeReg(NRF24L01_1C_DYNPD, 0x3F);       // Enable dynamic payload length on all pipes
-    
+    mDev.setRetransmit(1, RETR_MAX_COUNT, RETR_MAX_COUNT); // 500uS retransmit t/o, 9 retries, adaptive
+
     // this sequence necessary for module from stock tx
     mDev.readReg(NRF24L01_1D_FEATURE);
     mDev.activate(0x73);                          // Activate feature register
@@ -293,6 +289,8 @@ void RFProtocolYD717::updateTelemetry(void) {
 
 u16 RFProtocolYD717::callState(void)
 {
+    u8 status;
+
     switch (mState) {
     case YD717_INIT1:
         sendPacket(0);
@@ -319,6 +317,7 @@ u16 RFProtocolYD717::callState(void)
         case PKT_PENDING:
             return PACKET_CHKTIME_uS;           // packet send not yet complete
         case PKT_ACKED:
+            saveBind(mRxTxAddrBuf, sizeof(mRxTxAddrBuf));
             mState = YD717_DATA;
             break;
         case PKT_TIMEOUT:
@@ -334,9 +333,11 @@ u16 RFProtocolYD717::callState(void)
 #ifdef YD717_TELEMETRY
         update_telemetry();
 #endif
-        if (checkStatus() == PKT_PENDING)
+        status = checkStatus();
+        if (status == PKT_PENDING)
             return PACKET_CHKTIME_uS;           // packet send not yet complete
 
+        mDev.updateLinkStats(RF_CHANNEL, status == PKT_ACKED);
         sendPacket(0);
         break;
     }
@@ -347,7 +348,9 @@ int RFProtocolYD717::init(void)
 {
     mPacketCtr = 0;
 
-    initRxTxAddr();
+    // YD717_INIT1 tries the data phase first and binds only when not acked
+    if (!isResume() || !loadBind(mRxTxAddrBuf, sizeof(mRxTxAddrBuf)))
+        initRxTxAddr();
     init1();
     mState = YD717_INIT1;
 
@@ -384,6 +387,10 @@ int RFProtocolYD717::getInfo(s8 id, u8 *data)
                 size = 1;
                 break;
 
+            case INFO_LINK_STATS:
+                size = mDev.getLinkStats(data);
+                break;
+
             case INFO_PACKET_CTR:
                 size = sizeof(mPacketCtr);
                 *((u32*)data) = mPacketCtr;
@@ -392,3 +399,20 @@ int RFProtocolYD717::getInfo(s8 id, u8 *data)
     }
     return size;
 }
+
+// YD717_BIND3 rebinds when the receiver does not ack the data packet
+int RFProtocolYD717::stopBind(void)
+{
+    if (mState == YD717_BIND2)
+        mBindCtr = 0;
+    else if (mState != YD717_DATA)
+        return -1;
+    return 0;
+}
+
+u8 RFProtocolYD717::getBindProgress(void)
+{
+    if (mState == YD717_BIND2)
+        return calcBindProgress(mBindCtr, MAX_BIND_COUNT);
+    return (mState == YD717_DATA) ? 100 : 0;
+}
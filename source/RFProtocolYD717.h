@@ -23,11 +23,14 @@
 class RFProtocolYD717 : public RFProtocol
 {
 #define PAYLOADSIZE          8  // receive data pipes set to this size, but unused
-#define MAX_PACKET_SIZE      9  // YD717 packets have 8-byte payload, Syma X4 is 9
-#define ADDR_BUF_SIZE        5
 
 public:
-    RFProtocolYD717(u32 id):RFProtocol(id) { }
+    enum {
+        MAX_PACKET_SIZE = 9,                // YD717 packets have 8-byte payload, Syma X4 is 9
+        ADDR_BUF_SIZE   = 5,
+    };
+
+    RFProtocolYD717(u32 id):RFProtocol(id), mDev(getPins()) { }
     ~RFProtocolYD717() { close(); }
 
 // for protocol
@@ -36,6 +39,10 @@ public:
     virtual int  reset(void);
     virtual int  getInfo(s8 id, u8 *data);
     virtual u16  callState(void);
+    virtual int  stopBind(void);
+    virtual u8   getBindProgress(void);
+    virtual void sleep(void)        { mDev.powerDown(); }
+    virtual void wake(void)         { mDev.powerUp();   }
 
 private:
     u8   getCheckSum(u8 *data);
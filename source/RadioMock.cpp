@@ -0,0 +1,111 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#include "RadioMock.h"
+
+#ifdef RF_MOCK
+
+RadioMock::REC_T    RadioMock::mRecs[MOCK_MAX_RECORDS];
+RadioMock::REC_T   *RadioMock::mCur = NULL;
+u16                 RadioMock::mCount = 0;
+u32                 RadioMock::mDropped = 0;
+u32                 RadioMock::mTime = 0;
+RadioMock::MISO_CB  RadioMock::mMISOCallback = NULL;
+
+void RadioMock::reset(void)
+{
+    mCur     = NULL;
+    mCount   = 0;
+    mDropped = 0;
+    mTime    = 0;
+}
+
+void RadioMock::clear(void)
+{
+    mCur     = NULL;
+    mCount   = 0;
+    mDropped = 0;
+}
+
+RadioMock::REC_T *RadioMock::newRecord(u8 type, u8 pin)
+{
+    REC_T *rec;
+
+    if (mCount >= MOCK_MAX_RECORDS) {
+        mDropped++;
+        return NULL;
+    }
+    rec = &mRecs[mCount++];
+    rec->time = mTime;
+    rec->type = type;
+    rec->pin  = pin;
+    rec->size = 0;
+    return rec;
+}
+
+void RadioMock::select(u8 csn)
+{
+    mCur = newRecord(REC_SPI, csn);
+}
+
+void RadioMock::deselect(u8 csn)
+{
+    mCur = NULL;
+}
+
+u8 RadioMock::xfer(u8 data)
+{
+    u8 idx = 0;
+
+    mTime += MOCK_BYTE_uS;
+    if (!mCur)
+        return 0;
+
+    idx = mCur->size;
+    if (idx < MOCK_MAX_XFER)
+        mCur->data[idx] = data;
+    if (mCur->size < 0xff)
+        mCur->size++;
+
+    if (mMISOCallback)
+        return (*mMISOCallback)(mCur->pin, idx, mCur->data);
+    return 0;
+}
+
+void RadioMock::setPin(u8 pin, u8 val)
+{
+    REC_T *rec = newRecord(REC_PIN, pin);
+
+    if (rec) {
+        rec->size    = 1;
+        rec->data[0] = val;
+    }
+}
+
+// one line per record : time type pin bytes...
+void RadioMock::dump(FILE *fp)
+{
+    for (u16 i = 0; i < mCount; i++) {
+        REC_T *rec = &mRecs[i];
+        u8    size = (rec->size > MOCK_MAX_XFER) ? MOCK_MAX_XFER : rec->size;
+
+        fprintf(fp, "%10u %s %3d", (unsigned)rec->time, (rec->type == REC_SPI) ? "spi" : "pin", rec->pin);
+        for (u8 j = 0; j < size; j++)
+            fprintf(fp, " %02x", rec->data[j]);
+        if (rec->size > size)
+            fprintf(fp, " +%d", rec->size - size);
+        fprintf(fp, "\n");
+    }
+}
+
+#endif
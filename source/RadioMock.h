@@ -0,0 +1,79 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _RADIO_MOCK_H_
+#define _RADIO_MOCK_H_
+
+#include "common.h"
+
+#ifdef RF_MOCK
+
+#include <stdio.h>
+
+#define MOCK_MAX_RECORDS    4096
+#define MOCK_MAX_XFER       40
+#define MOCK_BYTE_uS        1           // 8MHz SCK + loop overhead
+
+// host side radio bus.
+// every chip select cycle and every control pin change is recorded with the virtual time.
+// the clock only moves by SPI traffic and advance(), the host micros() should return getTime().
+class RadioMock
+{
+public:
+    enum {
+        REC_SPI,
+        REC_PIN,
+    };
+
+    typedef struct {
+        u32 time;
+        u8  type;
+        u8  pin;                    // csn for REC_SPI
+        u8  size;                   // bytes on the bus, data keeps the first MOCK_MAX_XFER
+        u8  data[MOCK_MAX_XFER];    // MOSI bytes, pin level for REC_PIN
+    } REC_T;
+
+    // returns MISO byte for the idx-th byte of a transaction
+    typedef u8 (*MISO_CB)(u8 csn, u8 idx, const u8 *mosi);
+
+    static void reset(void);
+    static void clear(void);        // drops the records, keeps the time
+    static void setMISOCallback(MISO_CB cb) { mMISOCallback = cb; }
+
+    static u32  getTime(void)               { return mTime;  }
+    static void setTime(u32 us)             { mTime = us;    }
+    static void advance(u32 us)             { mTime += us;   }
+
+    static void select(u8 csn);
+    static void deselect(u8 csn);
+    static u8   xfer(u8 data);
+    static void setPin(u8 pin, u8 val);
+
+    static u16  getCount(void)              { return mCount; }
+    static u32  getDropped(void)            { return mDropped; }
+    static const REC_T *get(u16 idx)        { return (idx < mCount) ? &mRecs[idx] : NULL; }
+    static void dump(FILE *fp);
+
+private:
+    static REC_T *newRecord(u8 type, u8 pin);
+
+    static REC_T   mRecs[MOCK_MAX_RECORDS];
+    static REC_T  *mCur;
+    static u16     mCount;
+    static u32     mDropped;
+    static u32     mTime;
+    static MISO_CB mMISOCallback;
+};
+
+#endif
+#endif
@@ -15,7 +15,7 @@
 #ifndef _SERIAL_PROTOCOL_H_
 #define _SERIAL_PROTOCOL_H_
 
-#include "Common.h"
+#include "common.h"
 #include "utils.h"
 #include <stdarg.h>
 
@@ -28,7 +28,8 @@ public:
     typedef enum {
         CMD_GET_VERSION,
         CMD_SET_RFPROTOCOL,     // data u32  : (module << 16 | proto << 8 | option)
-        CMD_START_RF,
+        CMD_START_RF,           // data u32 controller id, u8 rf power, u8 resume (optional) : 1 to skip binding
+                                // with a bind record, 4 models per module are kept, the oldest is replaced
         CMD_STOP_RF,
         CMD_SET_RF_POWER,
         
@@ -36,9 +37,25 @@ public:
         CMD_GET_INFO,
         CMD_GET_FREE_RAM,
         CMD_CHANGE_BAUD,
+        CMD_SET_PINS,           // data u8[4] : csn, ce(txen), rxen, irq. 0xff for not connected. fails after CMD_START_RF
+        CMD_SET_POWER_MODE,     // data u8    : RFProtocol::POWER_ALWAYS_ON, POWER_STANDBY, POWER_DOWN
+        CMD_GET_TELEMETRY,      // resp TELEMETRY_T, empty if the protocol has no telemetry
+        CMD_BIND_START,         // resp u8 1 : ok, fails before CMD_START_RF
+        CMD_BIND_STOP,          // resp u8 1 : stopped or already bound, 0 : waits for the receiver or not started
+        CMD_GET_BIND_PROGRESS,  // resp u8 % of binding done, 100 when bound
+        CMD_GET_PROTOCOL,       // data u8 index, resp u8 index, u8 count, PROTO_INFO_T (missing if index >= count)
+        CMD_SET_FAILSAFE,       // data u16 channel mask, s16[12] values in TREA order. saved to EEPROM, fails before CMD_START_RF
+        CMD_SET_INPUT_MODE,     // data u8 ControlInput::MODE_xxx, fails for PPM while a protocol drives PPM_PIN
+        CMD_GET_INPUT_STATS,    // data u8 1 : clear after reading, resp INPUT_STATS_T[2] : serial, PPM
+        CMD_SET_CHANNEL_COUNT,  // data u8 count, 0 : query only. resp u8 count in use, 0 : no protocol
         CMD_TEST = 110,
     } CMD_T;
 
+    // bit 7 of command selects the protocol slot
+    #define CMD_SLOT_BIT    0x80
+    static u8 getSlot(u8 cmd)   { return (cmd & CMD_SLOT_BIT) ? 1 : 0; }
+    static u8 getCmd(u8 cmd)    { return cmd & ~CMD_SLOT_BIT; }
+
     SerialProtocol();
     ~SerialProtocol();
 
@@ -0,0 +1,202 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// For Arduino 1.0 and earlier
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include "Storage.h"
+
+#define STORAGE_MAGIC       0x57        // changes with the slot layout
+#define ADDR_MAGIC          0
+#define ADDR_BOOT_CTR       1
+#define ADDR_SLOT_BASE      4
+
+// record : key(4) stamp(2) data(size) checksum(1)
+#define REC_HDR_SIZE        7
+#define MAX_SLOT_SIZE       30
+
+static const PROGMEM u8 TBL_SLOT_SIZES[Storage::MAX_SLOT] = {
+    4,                  // SLOT_CYRF_CHANNELS
+    4,                  // SLOT_A7105_CALIB
+    BIND_RECORD_SIZE, BIND_RECORD_SIZE, BIND_RECORD_SIZE, BIND_RECORD_SIZE,    // SLOT_BIND_NRF24L01
+    BIND_RECORD_SIZE, BIND_RECORD_SIZE, BIND_RECORD_SIZE, BIND_RECORD_SIZE,    // SLOT_BIND_A7105
+    BIND_RECORD_SIZE, BIND_RECORD_SIZE, BIND_RECORD_SIZE, BIND_RECORD_SIZE,    // SLOT_BIND_CYRF6936
+    30,                 // SLOT_FAILSAFE_NRF24L01
+    30,                 // SLOT_FAILSAFE_A7105
+    30,                 // SLOT_FAILSAFE_CYRF6936
+};
+
+u16 Storage::mBootCtr = 0;
+u16 Storage::mPostAddr;
+u8  Storage::mPostSize;
+u8  Storage::mPostPos;
+u8  Storage::mPostBuf[REC_HDR_SIZE + MAX_SLOT_SIZE];
+
+void Storage::begin(void)
+{
+    if (eeprom_read_byte((u8*)ADDR_MAGIC) != STORAGE_MAGIC) {
+        for (u8 i = 0; i < MAX_SLOT; i++)
+            erase(i);
+        mBootCtr = 0;
+        eeprom_update_byte((u8*)ADDR_MAGIC, STORAGE_MAGIC);
+    } else {
+        mBootCtr = eeprom_read_word((u16*)ADDR_BOOT_CTR) + 1;
+    }
+    eeprom_update_word((u16*)ADDR_BOOT_CTR, mBootCtr);
+}
+
+u16 Storage::getBootCtr(void)
+{
+    return mBootCtr;
+}
+
+u16 Storage::getSlotAddr(u8 slot)
+{
+    u16 addr = ADDR_SLOT_BASE;
+
+    for (u8 i = 0; i < slot; i++)
+        addr += REC_HDR_SIZE + pgm_read_byte(TBL_SLOT_SIZES + i);
+    return addr;
+}
+
+u8 Storage::getSlotSize(u8 slot)
+{
+    if (slot >= MAX_SLOT)
+        return 0;
+    return pgm_read_byte(TBL_SLOT_SIZES + slot);
+}
+
+u8 Storage::calcCheckSum(u32 key, u16 stamp, const u8 *data, u8 size)
+{
+    u8 sum = 0xa5 ^ size;
+
+    for (u8 i = 0; i < 4; i++) {
+        sum = (sum << 1 | sum >> 7) ^ (key & 0xff);
+        key >>= 8;
+    }
+    sum = (sum << 1 | sum >> 7) ^ (stamp & 0xff);
+    sum = (sum << 1 | sum >> 7) ^ (stamp >> 8);
+    for (u8 i = 0; i < size; i++)
+        sum = (sum << 1 | sum >> 7) ^ *data++;
+    return sum;
+}
+
+s16 Storage::read(u8 slot, u32 key, void *data, u8 size)
+{
+    u32 recKey;
+    u16 stamp;
+    u16 addr;
+
+    if (slot >= MAX_SLOT || size > getSlotSize(slot))
+        return -1;
+
+    addr   = getSlotAddr(slot);
+    recKey = eeprom_read_dword((u32*)addr);
+    if (recKey != key)
+        return -1;
+
+    stamp = eeprom_read_word((u16*)(addr + 4));
+    eeprom_read_block(data, (void*)(addr + 6), size);
+    if (eeprom_read_byte((u8*)(addr + 6 + size)) != calcCheckSum(key, stamp, (u8*)data, size))
+        return -1;
+
+    stamp = mBootCtr - stamp;
+    return (stamp > 0x7fff) ? 0x7fff : stamp;
+}
+
+void Storage::write(u8 slot, u32 key, const void *data, u8 size)
+{
+    u16 addr;
+
+    if (slot >= MAX_SLOT || size > getSlotSize(slot))
+        return;
+
+    flush();
+    addr = getSlotAddr(slot);
+    eeprom_update_dword((u32*)addr, key);
+    eeprom_update_word((u16*)(addr + 4), mBootCtr);
+    eeprom_update_block(data, (void*)(addr + 6), size);
+    eeprom_update_byte((u8*)(addr + 6 + size), calcCheckSum(key, mBootCtr, (const u8*)data, size));
+}
+
+// the key goes first and the checksum last, a record cut by a reset reads as invalid
+bool Storage::post(u8 slot, u32 key, const void *data, u8 size)
+{
+    if (slot >= MAX_SLOT || size > getSlotSize(slot) || size > MAX_SLOT_SIZE)
+        return true;        // dropped like write() does
+    if (mPostPos < mPostSize)
+        return false;
+
+    memcpy(mPostBuf, &key, 4);
+    memcpy(mPostBuf + 4, &mBootCtr, 2);
+    memcpy(mPostBuf + 6, data, size);
+    mPostBuf[6 + size] = calcCheckSum(key, mBootCtr, (const u8*)data, size);
+    mPostAddr = getSlotAddr(slot);
+    mPostSize = REC_HDR_SIZE + size;
+    mPostPos  = 0;
+    return true;
+}
+
+// avr-libc reads wait for a running write, so nothing is touched until the EEPROM is ready.
+// an unchanged byte does not start a write and the next one follows in the same pass
+bool Storage::poll(void)
+{
+    while (mPostPos < mPostSize) {
+        if (!eeprom_is_ready())
+            return true;
+        eeprom_update_byte((u8*)(mPostAddr + mPostPos), mPostBuf[mPostPos]);
+        mPostPos++;
+    }
+    return false;
+}
+
+void Storage::flush(void)
+{
+    if (mPostPos < mPostSize) {
+        eeprom_update_block(mPostBuf + mPostPos, (void*)(mPostAddr + mPostPos), mPostSize - mPostPos);
+        mPostPos = mPostSize;
+    }
+}
+
+s16 Storage::getAge(u8 slot)
+{
+    u16 addr;
+    u16 stamp;
+
+    if (slot >= MAX_SLOT)
+        return -1;
+
+    addr = getSlotAddr(slot);
+    if (eeprom_read_dword((u32*)addr) == 0xffffffff)
+        return -1;
+    stamp = mBootCtr - eeprom_read_word((u16*)(addr + 4));
+    return (stamp > 0x7fff) ? 0x7fff : stamp;
+}
+
+void Storage::erase(u8 slot)
+{
+    if (slot >= MAX_SLOT)
+        return;
+
+    // flipping the first data byte breaks the checksum of the record
+    u16 addr = getSlotAddr(slot);
+    u8  val  = eeprom_read_byte((u8*)(addr + 6));
+    eeprom_update_byte((u8*)(addr + 6), ~val);
+    eeprom_update_dword((u32*)addr, 0xffffffff);
+}
@@ -0,0 +1,71 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef _STORAGE_H_
+#define _STORAGE_H_
+
+#include "common.h"
+
+#define BIND_RECORDS        4       // models remembered per module, the oldest is replaced
+#define BIND_RECORD_SIZE    16      // protocol id(4) + bind data
+
+// EEPROM backed records.
+// every slot has a fixed place and size, a record is only returned when its key
+// matches and the checksum is valid. records are stamped with the boot counter
+// so callers can decide how old a cached value may be.
+class Storage
+{
+public:
+    enum {
+        SLOT_CYRF_CHANNELS,
+        SLOT_A7105_CALIB,
+        SLOT_BIND_NRF24L01,     // bind identities, BIND_RECORDS per module in RFProtocol::TX_xxx order
+        SLOT_BIND_A7105     = SLOT_BIND_NRF24L01 + BIND_RECORDS,
+        SLOT_BIND_CYRF6936  = SLOT_BIND_A7105 + BIND_RECORDS,
+        SLOT_FAILSAFE_NRF24L01 = SLOT_BIND_CYRF6936 + BIND_RECORDS,  // failsafe table, one per module in RFProtocol::TX_xxx order
+        SLOT_FAILSAFE_A7105,
+        SLOT_FAILSAFE_CYRF6936,
+        MAX_SLOT
+    };
+
+    static void begin(void);
+    static u16  getBootCtr(void);
+
+    // returns age of the record in boots, -1 if there is no valid record
+    static s16  read(u8 slot, u32 key, void *data, u8 size);
+    static void write(u8 slot, u32 key, const void *data, u8 size);
+    static void erase(u8 slot);
+
+    // background write for callers on the packet path : post() copies the record, poll()
+    // from the main loop writes one byte when the EEPROM is ready (3.3ms per changed byte).
+    // post() returns false while another record is being written, the caller tries again
+    static bool post(u8 slot, u32 key, const void *data, u8 size);
+    static bool poll(void);     // true while a posted record is not complete
+    static void flush(void);    // completes the posted record, blocking
+
+    // age of any record in the slot without checking it, -1 if the slot is erased
+    static s16  getAge(u8 slot);
+    static u8   getSlotSize(u8 slot);
+
+private:
+    static u16  getSlotAddr(u8 slot);
+    static u8   calcCheckSum(u32 key, u16 stamp, const u8 *data, u8 size);
+
+    static u16  mBootCtr;
+    static u16  mPostAddr;
+    static u8   mPostSize;
+    static u8   mPostPos;
+    static u8   mPostBuf[];
+};
+
+#endif
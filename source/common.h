@@ -24,7 +24,7 @@
 
 //Magic macro to check enum size
 //#define ctassert(n,e) extern unsigned char n[(e)?0:-1]
-#define ctassert(COND,MSG) typedef char static_assertion_##MSG[(COND)?1:-1]
+#define ctassert(COND,MSG) typedef char static_assertion_##MSG[(COND)?1:-1] __attribute__((unused))
 
 typedef int8_t s8;
 typedef int16_t s16;
@@ -65,4 +65,14 @@ enum TXRX_State {
     RX_EN,
 };
 
+#define PIN_NONE    0xff
+
+// radio module wiring
+typedef struct {
+    u8 csn;
+    u8 ce;          // CE for NRF24L01, TXEN for A7105
+    u8 rxen;        // RXEN for A7105
+    u8 irq;
+} RFPINS_T;
+
 #endif
@@ -20,15 +20,12 @@
 
 #include "common.h"
 #include "utils.h"
-#include "RFProtocolSyma.h"
-#include "RFProtocolYD717.h"
-#include "RFProtocolV2x2.h"
-#include "RFProtocolHiSky.h"
-#include "RFProtocolCFlie.h"
-#include "RFProtocolDevo.h"
-#include "RFProtocolHubsan.h"
-#include "RFProtocolFlysky.h"
+#include "DeviceNRF24L01.h"
+#include "RFProtocol.h"
+#include "ProtocolRegistry.h"
+#include "ControlInput.h"
 #include "SerialProtocol.h"
+#include "Storage.h"
 
 #define FW_VERSION  0x0100
 
@@ -36,122 +33,169 @@ static SerialProtocol  mSerial;
 static u8 mBaudAckLen;
 static u8 mBaudChkCtr;
 static u8 mBaudAckStr[12];
-static RFProtocol *mRFProto = NULL;
+
+static RFProtocol *mRFProtos[MAX_PROTO_SLOT];
+static u8  mRFStarted;                  // slot bits, pins are fixed after CMD_START_RF
+static u8  mInputLost;
+
+// output pins can not be shared between modules.
+// two protocols on one module share the chip by TDM when their timing fits
+static bool isAdmissible(u8 slot, RFProtocol *proto)
+{
+    RFProtocol *other = mRFProtos[slot ^ 1];
+    u16 hold1, hold2;
+
+    if (ControlInput::isPPMEnabled() && proto->isPinUsed(PPM_PIN))
+        return false;
+    if (!other)
+        return true;
+    if (other->getModule() != proto->getModule())
+        return !proto->isPinConflict(other);
+
+    if (memcmp(proto->getPins(), other->getPins(), sizeof(RFPINS_T)))
+        return false;
+    hold1 = ProtocolRegistry::getShareTime(proto->getProtoID(), other->getProtoID());
+    hold2 = ProtocolRegistry::getShareTime(other->getProtoID(), proto->getProtoID());
+    if (!hold1 || !hold2)
+        return false;
+    proto->setRadioShare(hold1);
+    other->setRadioShare(hold2);
+    return true;
+}
+
+static void deleteProtocol(u8 slot)
+{
+    if (mRFProtos[slot]) {
+        ProtocolRegistry::destroy(mRFProtos[slot]);
+        mRFProtos[slot] = NULL;
+        mRFStarted &= ~BV(slot);
+        // the chip is left to the other protocol, configured again when it runs.
+        // one not started yet configures it in init()
+        if (mRFProtos[slot ^ 1]) {
+            mRFProtos[slot ^ 1]->setRadioShare(0);
+            if (mRFStarted & BV(slot ^ 1))
+                mRFProtos[slot ^ 1]->restoreRadio();
+        }
+    }
+}
 
 u32 serialCallback(u8 cmd, u8 *data, u8 size)
 {
     u32 id;
     u16 ram;
     u8  ret = 0;
-    u8  buf[5];
+    u8  buf[1 + sizeof(NRF_CHAN_STAT_T) * NRF_MAX_STAT_CHANNELS];
     u8  sz = 0;
+    u8  slot = SerialProtocol::getSlot(cmd);
+    RFProtocol *proto = mRFProtos[slot];
 
-    switch (cmd) {
+    switch (SerialProtocol::getCmd(cmd)) {
         case SerialProtocol::CMD_GET_VERSION:
             ram = FW_VERSION;
             mSerial.sendResponse(true, cmd, (u8*)&ram, sizeof(ram));
             break;
 
         case SerialProtocol::CMD_SET_RFPROTOCOL:
-            if (mRFProto) {
-                delete mRFProto;
-                mRFProto = NULL;
-            }
-            
+            deleteProtocol(slot);
+
             id = *(u32*)data;
-            switch (RFProtocol::getModule(id)) {
-                case RFProtocol::TX_NRF24L01: {
-                    ret = 1;
-                    switch (RFProtocol::getProtocol(id)) {
-                        case RFProtocol::PROTO_NRF24L01_SYMAX:
-                            mRFProto = new RFProtocolSyma(id);
-                            break;
-
-                        case RFProtocol::PROTO_NRF24L01_YD717:
-                            mRFProto = new RFProtocolYD717(id);
-                            break;
-
-                        case RFProtocol::PROTO_NRF24L01_V2x2:
-                            mRFProto = new RFProtocolV2x2(id);
-                            break;
-
-                        case RFProtocol::PROTO_NRF24L01_HISKY:
-                            mRFProto = new RFProtocolHiSky(id);
-                            break;
-
-#if 0
-                        case RFProtocol::PROTO_NRF24L01_CFLIE:
-                            mRFProto = new RFProtocolCFlie(id);
-                            break;
-#endif
-                        default:
-                            ret = 0;
-                            break;
-                    }
-                }
-                break;
+            proto = ProtocolRegistry::create(id, slot);
+            if (proto && !isAdmissible(slot, proto)) {
+                ProtocolRegistry::destroy(proto);
+                proto = NULL;
+            }
+            mRFProtos[slot] = proto;
+            ret = (proto != NULL);
+            //mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            mSerial.sendResponse(true, cmd, (u8*)mBaudAckStr, mBaudAckLen);
+            break;
 
-                case RFProtocol::TX_CYRF6936:
-                    mRFProto = new RFProtocolDevo(id);
-                    ret = 1;
-                break;
+        case SerialProtocol::CMD_SET_PINS:
+            if (proto && !(mRFStarted & BV(slot)) && size >= sizeof(RFPINS_T)) {
+                RFPINS_T old = *proto->getPins();
 
-                case RFProtocol::TX_A7105: {
+                proto->setPins((RFPINS_T*)data);
+                if (isAdmissible(slot, proto))
                     ret = 1;
-                    switch (RFProtocol::getProtocol(id)) {
-                        case RFProtocol::PROTO_A7105_FLYSKY:
-                            mRFProto = new RFProtocolFlysky(id);
-                            break;
-
-                        case RFProtocol::PROTO_A7105_HUBSAN:
-                            mRFProto = new RFProtocolHubsan(id);
-                            break;
-
-                        default:
-                            ret = 0;
-                            break;
-                    }
-                }
-                break;
-                    
+                else
+                    proto->setPins(&old);
             }
-            //mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
-            mSerial.sendResponse(true, cmd, (u8*)mBaudAckStr, mBaudAckLen);
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
             break;
 
         case SerialProtocol::CMD_START_RF:
             id = *(u32*)data;
             sz = *(data + 4);
-            if (mRFProto) {
-                mRFProto->setControllerID(id);
-                mRFProto->setRFPower(sz);
-                mRFProto->init();
+            if (proto) {
+                proto->setControllerID(id);
+                proto->loadFailsafe();
+                proto->setRFPower(sz);
+                proto->setResume(size > 5 && *(data + 5));
+                proto->init();
+                mRFStarted |= BV(slot);
                 ret = 1;
             }
             mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
             break;
 
         case SerialProtocol::CMD_STOP_RF:
-            if (mRFProto) {
-                mRFProto->close();
-                delete mRFProto;
-                mRFProto = NULL;
+            if (proto) {
+                proto->close();
+                deleteProtocol(slot);
                 ret = 1;
             }
             mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
             break;
 
         case SerialProtocol::CMD_SET_RF_POWER:
-            if (mRFProto) {
-                mRFProto->setRFPower(*data);
+            if (proto) {
+                proto->setRFPower(*data);
+                ret = 1;
+            }
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            break;
+
+        case SerialProtocol::CMD_SET_POWER_MODE:
+            if (proto && proto->setPowerMode(*data) == 0)
                 ret = 1;
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            break;
+
+        case SerialProtocol::CMD_GET_TELEMETRY:
+            {
+                TELEMETRY_T *telem = proto ? proto->getTelemetry() : NULL;
+
+                if (telem) {
+                    mSerial.sendResponse(true, cmd, (u8*)telem, sizeof(TELEMETRY_T));
+                    telem->updated = 0;
+                    ret = 1;
+                } else {
+                    mSerial.sendResponse(true, cmd, NULL, 0);
+                }
             }
+            break;
+
+        case SerialProtocol::CMD_BIND_START:
+            if (proto && (mRFStarted & BV(slot)) && proto->startBind() == 0)
+                ret = 1;
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            break;
+
+        case SerialProtocol::CMD_BIND_STOP:
+            if (proto && (mRFStarted & BV(slot)) && proto->stopBind() == 0)
+                ret = 1;
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            break;
+
+        case SerialProtocol::CMD_GET_BIND_PROGRESS:
+            if (proto)
+                ret = proto->getBindProgress();
             mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
             break;
 
         case SerialProtocol::CMD_INJECT_CONTROLS:
-            if (mRFProto) {
-                mRFProto->injectControls((s16*)data, size >> 1);
+            if (ControlInput::putSerial() && proto) {
+                proto->injectControls((s16*)data, size >> 1);
                 ret = 1;
             }
             mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
@@ -159,12 +203,70 @@ u32 serialCallback(u8 cmd, u8 *data, u8 size)
 
         case SerialProtocol::CMD_GET_INFO:
             buf[0] = *data;
-            if (mRFProto) {
-                sz = mRFProto->getInfo(buf[0], &buf[1]);
+            if (proto) {
+                sz = proto->getInfo(buf[0], &buf[1]);
             }
             mSerial.sendResponse(true, cmd, buf, sz + 1);
             break;
 
+        case SerialProtocol::CMD_GET_PROTOCOL:
+            {
+                u8 info[2 + sizeof(PROTO_INFO_T)];
+
+                info[0] = *data;
+                info[1] = ProtocolRegistry::getCount();
+                sz = 2;
+                if (ProtocolRegistry::getInfo(info[0], (PROTO_INFO_T*)&info[2])) {
+                    sz += sizeof(PROTO_INFO_T);
+                    ret = 1;
+                }
+                mSerial.sendResponse(true, cmd, info, sz);
+            }
+            break;
+
+        case SerialProtocol::CMD_SET_FAILSAFE:
+            // the record is keyed by the controller id of CMD_START_RF, loop() writes it
+            if (proto && (mRFStarted & BV(slot)) && size >= 2 + RFProtocol::MAX_CHANNEL * sizeof(s16)) {
+                proto->setFailsafe(*(u16*)data, (s16*)(data + 2));
+                proto->saveFailsafe();
+                ret = 1;
+            }
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            break;
+
+        case SerialProtocol::CMD_SET_INPUT_MODE:
+            ret = 1;
+            if (*data != ControlInput::MODE_SERIAL) {
+                for (u8 i = 0; i < MAX_PROTO_SLOT; i++) {
+                    if (mRFProtos[i] && mRFProtos[i]->isPinUsed(PPM_PIN))
+                        ret = 0;
+                }
+            }
+            if (ret)
+                ret = ControlInput::setMode(*data);
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            break;
+
+        case SerialProtocol::CMD_GET_INPUT_STATS:
+            {
+                INPUT_STATS_T stats[ControlInput::MAX_SRC];
+
+                ControlInput::getStats(stats);
+                if (size > 0 && *data)
+                    ControlInput::clearStats();
+                mSerial.sendResponse(true, cmd, (u8*)stats, sizeof(stats));
+            }
+            break;
+
+        case SerialProtocol::CMD_SET_CHANNEL_COUNT:
+            if (proto) {
+                if (size > 0 && *data && *data <= ProtocolRegistry::getMaxChannels(proto->getProtoID()))
+                    proto->setChannelCount(*data);
+                ret = proto->getChannelCount();
+            }
+            mSerial.sendResponse(true, cmd, (u8*)&ret, sizeof(ret));
+            break;
+
         case SerialProtocol::CMD_GET_FREE_RAM:
             ram = freeRam();
             mSerial.sendResponse(true, cmd, (u8*)&ram, sizeof(ram));
@@ -191,6 +293,7 @@ u32 serialCallback(u8 cmd, u8 *data, u8 size)
 
 void setup()
 {
+    Storage::begin();
     mSerial.begin(9600);
     mSerial.setCallback(serialCallback);
     mBaudChkCtr = 0;
@@ -212,8 +315,31 @@ void loop()
         mBaudChkCtr++;
     } else {
         mSerial.handleRX();
-        if (mRFProto)
-            mRFProto->loop();
+        if (ControlInput::isPPMEnabled()) {
+            s16 ppm[RFProtocol::MAX_CHANNEL];
+            u8  size = ControlInput::fetchPPM(ppm);
+
+            for (u8 i = 0; size && i < MAX_PROTO_SLOT; i++) {
+                if (mRFProtos[i])
+                    mRFProtos[i]->injectControls(ppm, size);
+            }
+        }
+
+        // failsafe values are sent once when all control sources are lost
+        if (ControlInput::getSource() != ControlInput::SRC_NONE) {
+            mInputLost = 0;
+        } else if (!mInputLost) {
+            mInputLost = 1;
+            for (u8 i = 0; i < MAX_PROTO_SLOT; i++) {
+                if (mRFProtos[i])
+                    mRFProtos[i]->applyFailsafe();
+            }
+        }
+        for (u8 i = 0; i < MAX_PROTO_SLOT; i++) {
+            if (mRFProtos[i])
+                mRFProtos[i]->loop();
+        }
+        Storage::poll();
     }
 }
 
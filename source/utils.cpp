@@ -18,7 +18,7 @@
 #include "utils.h"
 
 
-static const u32 rand_seed = 0xb2c54a2ful;
+static u32 rand_seed = 0xb2c54a2ful;
 // Linear feedback shift register with 32-bit Xilinx polinomial x^32 + x^22 + x^2 + x + 1
 static const u32 LFSR_FEEDBACK = 0x80200003ul;
 static const u32 LFSR_INTAP = 32-1;
@@ -17,10 +17,10 @@
 #define _UTILS_H_
 #include <Arduino.h>
 #include <avr/pgmspace.h>
-#include "Common.h"
+#include "common.h"
 
 // Bit vector from bit position
-#define BV(bit) (1 << bit)
+#define BV(bit) (1 << (bit))
 
 u32  rand32_r(u32 *seed, u8 update);
 u32  rand32();
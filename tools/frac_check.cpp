@@ -0,0 +1,125 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// host check of RFProtocolCFlie::frac2float against the bit by bit loop it replaced.
+//
+//   the frac_check target of the host build (CMakeLists.txt)
+//
+//   ./frac_check                   compare, exit 1 on the first difference.
+//                                  then prints the shift steps per call of both encoders
+//                                  and the host time per call for every input bit length
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "RFProtocolCFlie.h"
+
+#define FRAC_MANTISSA   16
+#define DENSE_RANGE     (1L << 24)      // every input below, both signs
+#define RANDOM_COUNT    (1L << 24)
+#define TIME_CALLS      (1L << 20)
+
+static u32 mRefSteps;
+
+// the encoder of deviation, one shift per leading zero
+static void refFrac2float(s32 n, float *res)
+{
+    if (n == 0) {
+        *res = 0.0;
+        return;
+    }
+    u32 m = n < 0 ? -n : n;
+    int i;
+    for (i = (31-FRAC_MANTISSA); (m & 0x80000000) == 0; i--, m <<= 1)
+        mRefSteps++;
+    m <<= 1; // Clear implicit leftmost 1
+    m >>= 9;
+    u32 e = 127 + i;
+    if (n < 0) m |= 0x80000000;
+    m |= e << 23;
+    *((u32 *) res) = m;
+}
+
+static bool check(s32 n)
+{
+    float a, b;
+
+    RFProtocolCFlie::frac2float(n, &a);
+    refFrac2float(n, &b);
+    if (memcmp(&a, &b, sizeof(a))) {
+        fprintf(stdout, "%08x : %08x, reference %08x\n", (unsigned)n, *(unsigned *)&a, *(unsigned *)&b);
+        return false;
+    }
+    return true;
+}
+
+static double nsPerCall(void (*fn)(s32, float *), s32 n)
+{
+    volatile float sink;
+    float   res;
+    clock_t start = clock();
+
+    for (long i = 0; i < TIME_CALLS; i++) {
+        fn(n | (i & 1), &res);     // not a constant, the call can not be hoisted
+        sink = res;
+    }
+    (void)sink;
+    return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / TIME_CALLS;
+}
+
+int main(void)
+{
+    u32  seed = 1;
+    long cnt  = 0;
+
+    for (s32 n = 0; n < DENSE_RANGE; n++, cnt += 2) {
+        if (!check(n) || !check(-n))
+            return 1;
+    }
+    // every bit length with its neighbours, both signs
+    for (u8 b = 0; b < 31; b++, cnt += 6) {
+        s32 n = (s32)1 << b;
+        if (!check(n) || !check(n - 1) || !check(n + 1) || !check(-n) || !check(1 - n) || !check(-n - 1))
+            return 1;
+    }
+    if (!check(0x7fffffff) || !check(-0x7fffffff))
+        return 1;
+    for (long i = 0; i < RANDOM_COUNT; i++, cnt++) {
+        seed = seed * 1103515245UL + 12345UL;
+        if (seed == 0x80000000UL)
+            continue;
+        if (!check((s32)seed))
+            return 1;
+    }
+    fprintf(stdout, "%ld inputs : ok\n", cnt + 2);
+
+    // the loop runs once per leading zero, frac2float has no loop : 3 masked shifts and a table
+    float res;
+    mRefSteps = 0;
+    refFrac2float(1, &res);
+    fprintf(stdout, "worst case loop passes : reference %u, frac2float 0\n", (unsigned)mRefSteps);
+
+    // host time, the spread over bit lengths is what matters, not the figures
+    double refMax = 0, newMax = 0;
+    fprintf(stdout, "bits  reference ns  frac2float ns\n");
+    for (u8 b = 0; b < 31; b++) {
+        s32 n = (s32)1 << b;
+        double ref = nsPerCall(refFrac2float, n);
+        double enc = nsPerCall(RFProtocolCFlie::frac2float, n);
+        fprintf(stdout, "%4u  %12.2f  %13.2f\n", b + 1, ref, enc);
+        refMax = (ref > refMax) ? ref : refMax;
+        newMax = (enc > newMax) ? enc : newMax;
+    }
+    fprintf(stdout, "worst case ns per call : reference %.2f, frac2float %.2f\n", refMax, newMax);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// host side generator of HiSky hopping tables, built from the firmware source.
+//
+//   g++ -O2 -I../source -o hisky_hop hisky_hop.cpp ../source/HiSkyHop.cpp
+//   or the hisky_hop target of the host build (CMakeLists.txt)
+//
+//   ./hisky_hop                    golden tables, compare with hisky_hop.golden
+//   ./hisky_hop -c hisky_hop.golden    compare, exit 1 on difference
+//   ./hisky_hop seed ...           tables of given seeds (hex)
+//   ./hisky_hop -s count           draws statistics over count seeds
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HiSkyHop.h"
+
+#define GOLDEN_SEEDS    64
+#define LINE_SIZE       128
+
+static u32 nextSeed(u32 seed)
+{
+    return seed * 1103515245UL + 12345UL;
+}
+
+static void formatTable(u32 seed, char *line)
+{
+    u8  chans[HISKY_HOP_CHANNELS];
+    u16 draws = HiSkyHop::build(seed, chans);
+    int len;
+
+    len = sprintf(line, "%08lx :", (unsigned long)seed);
+    for (u8 i = 0; i < HISKY_HOP_CHANNELS; i++)
+        len += sprintf(line + len, " %2d", chans[i]);
+    sprintf(line + len, " : %d\n", draws);
+}
+
+static void printTable(u32 seed)
+{
+    char line[LINE_SIZE];
+
+    formatTable(seed, line);
+    fputs(line, stdout);
+}
+
+// golden tables against the file, the line of the first difference or 0
+static int compareGolden(FILE *fp)
+{
+    char line[LINE_SIZE];
+    char golden[LINE_SIZE];
+    u32  seed = 0;
+
+    for (int i = 0; i < GOLDEN_SEEDS; i++) {
+        seed = nextSeed(seed);
+        formatTable(seed, line);
+        if (!fgets(golden, sizeof(golden), fp) || strcmp(line, golden))
+            return i + 1;
+    }
+    return fgets(golden, sizeof(golden), fp) ? GOLDEN_SEEDS + 1 : 0;
+}
+
+static void printStats(u32 count)
+{
+    u8  chans[HISKY_HOP_CHANNELS];
+    u32 seed = 0;
+    u32 capped = 0;
+    u16 draws, max = 0;
+    u32 maxSeed = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        seed  = nextSeed(seed);
+        draws = HiSkyHop::build(seed, chans);
+        if (draws >= HISKY_HOP_MAX_DRAWS)
+            capped++;
+        if (draws > max) {
+            max     = draws;
+            maxSeed = seed;
+        }
+    }
+    printf("seeds %lu, max draws %d (seed %08lx), capped %lu\n",
+           (unsigned long)count, max, (unsigned long)maxSeed, (unsigned long)capped);
+}
+
+int main(int argc, char *argv[])
+{
+    u32 seed = 0;
+
+    if (argc > 2 && !strcmp(argv[1], "-c")) {
+        FILE *fp = fopen(argv[2], "r");
+        int  line;
+
+        if (!fp) {
+            fprintf(stderr, "can not open %s\n", argv[2]);
+            return 1;
+        }
+        line = compareGolden(fp);
+        fclose(fp);
+        if (line) {
+            fprintf(stdout, "%s : differs at line %d\n", argv[2], line);
+            return 1;
+        }
+        fprintf(stdout, "%s : ok\n", argv[2]);
+    } else if (argc > 2 && argv[1][0] == '-' && argv[1][1] == 's') {
+        printStats(strtoul(argv[2], NULL, 0));
+    } else if (argc > 1) {
+        for (int i = 1; i < argc; i++)
+            printTable(strtoul(argv[i], NULL, 16));
+    } else {
+        for (int i = 0; i < GOLDEN_SEEDS; i++) {
+            seed = nextSeed(seed);
+            printTable(seed);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// runs protocols of the registry on the host against RadioMock, see CMakeLists.txt.
+//
+//   ./host_run                     all protocols for 1s of virtual time, summary
+//   ./host_run -t ms               run time
+//   ./host_run -d index            one protocol, dump of the bus records
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostShim.h"
+#include "RadioMock.h"
+#include "ProtocolRegistry.h"
+#include "Storage.h"
+
+#define HOST_STEP_uS    10      // loop() resolution in virtual time
+#define CONTROLLER_ID   0x12345678UL
+
+static void run(RFProtocol *proto, u32 ms)
+{
+    u32 end = HostShim::getTime() + ms * 1000;
+
+    while (HostShim::getTime() < end) {
+        proto->loop();
+        Storage::poll();
+        HostShim::advance(HOST_STEP_uS);
+    }
+}
+
+static void runProtocol(u8 idx, u32 ms, bool dump)
+{
+    PROTO_INFO_T info;
+    RFProtocol  *proto;
+    u32 spi = 0;
+
+    ProtocolRegistry::getInfo(idx, &info);
+    HostShim::reset();
+    proto = ProtocolRegistry::create(RFProtocol::buildID(info.module, info.proto, 0), 0);
+    if (!proto) {
+        fprintf(stderr, "%-8.8s : can not create\n", info.name);
+        return;
+    }
+
+    proto->setControllerID(CONTROLLER_ID);
+    proto->init();
+    run(proto, ms);
+
+    for (u16 i = 0; i < RadioMock::getCount(); i++) {
+        if (RadioMock::get(i)->type == RadioMock::REC_SPI)
+            spi++;
+    }
+    fprintf(stdout, "%-8.8s : %6u records, %6u spi, %u dropped\n", info.name,
+            RadioMock::getCount(), (unsigned)spi, (unsigned)RadioMock::getDropped());
+    if (dump)
+        RadioMock::dump(stdout);
+
+    proto->close();
+    ProtocolRegistry::destroy(proto);
+}
+
+int main(int argc, char *argv[])
+{
+    u32 ms  = 1000;
+    int one = -1;
+
+    for (int i = 1; i < argc - 1; i++) {
+        if (!strcmp(argv[i], "-t"))
+            ms = strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-d"))
+            one = atoi(argv[++i]);
+    }
+
+    HostShim::eraseEEPROM();
+    Storage::begin();
+
+    for (u8 i = 0; i < ProtocolRegistry::getCount(); i++) {
+        if (one < 0 || one == i)
+            runProtocol(i, ms, one == i);
+    }
+    return 0;
+}
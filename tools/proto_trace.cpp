@@ -0,0 +1,360 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// SPI traces of every protocol : init, bind stopped after BIND_MS, data with scripted controls, then close.
+// a change of the trace means a change on the air, optimizations must keep them bit exact.
+//
+// two SymaX slots sharing the nRF24L01 by TDM are traced too, slots are set up and deleted
+// like CMD_SET_RFPROTOCOL and CMD_START_RF of source.ino do.
+//
+//   ./proto_trace -c traces        compare with golden traces, exit 1 on difference
+//   ./proto_trace -o traces        write golden traces
+//   ./proto_trace [-p index]       print to stdout, the index after the last protocol is the TDM trace
+//   -t ms                          virtual run time, goldens use the default
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostShim.h"
+#include "RadioMock.h"
+#include "ProtocolRegistry.h"
+#include "Storage.h"
+
+#define HOST_STEP_uS        10
+#define RUN_MS              300
+#define BIND_MS             100         // bind is cut short here, some protocols bind for seconds
+#define CONTROL_PERIOD_uS   20000       // host update rate
+#define CONTROLLER_ID       0x12345678UL
+#define NRF24L01_CSN        8           // default wiring, see RFProtocol.cpp
+#define A7105_CSN           10
+#define TDM_CONTROLLER_ID   0x0badcafeUL
+#define TDM_TRACE           "symax_tdm"
+
+// Hubsan bind reply : step 9 in byte 1 ends binding, the radio ID of the quad follows
+static const u8 TBL_A7105_FIFO[] = { 0x0a, 0x09, 0xdb, 0x04, 0x26, 0x79 };
+
+// A7105 : MODE and the calibration registers read 0 (done), the FIFO holds the bind reply
+static u8 misoA7105(u8 idx, const u8 *mosi)
+{
+    if (idx == 0 || mosi[0] != (0x40 | 0x05))
+        return 0;
+    return (idx <= sizeof(TBL_A7105_FIFO)) ? TBL_A7105_FIFO[idx - 1] : 0;
+}
+
+// nRF24L01 answers every packet as sent and acked so ack protocols get to the data phase.
+// the A7105 answers the Hubsan bind, CYRF6936 reads 0
+static u8 misoModel(u8 csn, u8 idx, const u8 *mosi)
+{
+    u8 reg = mosi[0] & 0x1f;
+
+    if (csn == A7105_CSN)
+        return misoA7105(idx, mosi);
+    if (csn != NRF24L01_CSN)
+        return 0;
+    if (idx == 0)
+        return 0x2e;                    // STATUS : TX_DS, RX FIFO empty
+    if ((mosi[0] & 0xe0) == 0 && reg == 0x07)
+        return 0x2e;
+    if ((mosi[0] & 0xe0) == 0 && reg == 0x17)
+        return 0x11;                    // FIFO_STATUS : TX and RX empty
+    return 0;
+}
+
+// triangles of 2s with a phase per channel
+static void injectScript(RFProtocol *proto)
+{
+    s16 controls[RFProtocol::MAX_CHANNEL];
+    u32 ms = HostShim::getTime() / 1000;
+
+    for (u8 i = 0; i < RFProtocol::MAX_CHANNEL; i++) {
+        u16 pos = (ms + i * 167) % 2000;
+        controls[i] = (pos < 1000) ? pos - 500 : 1500 - pos;
+    }
+    proto->injectControls(controls, RFProtocol::MAX_CHANNEL);
+}
+
+static void flushRecords(FILE *fp)
+{
+    RadioMock::dump(fp);
+    if (RadioMock::getDropped())
+        fprintf(fp, "# %u dropped\n", (unsigned)RadioMock::getDropped());
+    RadioMock::clear();
+}
+
+static bool trace(u8 idx, u32 ms, FILE *fp)
+{
+    PROTO_INFO_T info;
+    RFProtocol  *proto;
+    u32 id, end, bindEnd, nextCtl = 0;
+
+    ProtocolRegistry::getInfo(idx, &info);
+    id = RFProtocol::buildID(info.module, info.proto, 0);
+
+    HostShim::reset();
+    HostShim::eraseEEPROM();
+    Storage::begin();
+    RadioMock::setMISOCallback(misoModel);
+
+    proto = ProtocolRegistry::create(id, 0);
+    if (!proto)
+        return false;
+
+    fprintf(fp, "# %.8s %06x %u ms\n", info.name, (unsigned)id, (unsigned)ms);
+    proto->setControllerID(CONTROLLER_ID);
+    proto->init();
+
+    bindEnd = HostShim::getTime() + BIND_MS * 1000;
+    end     = HostShim::getTime() + ms * 1000;
+    while (HostShim::getTime() < end) {
+        if (bindEnd && HostShim::getTime() >= bindEnd) {
+            flushRecords(fp);
+            fprintf(fp, "# stop bind %d\n", proto->stopBind());
+            bindEnd = 0;
+        }
+        if (HostShim::getTime() >= nextCtl) {
+            injectScript(proto);
+            nextCtl += CONTROL_PERIOD_uS;
+        }
+        proto->loop();
+        Storage::poll();
+        HostShim::advance(HOST_STEP_uS);
+        if (RadioMock::getCount() >= MOCK_MAX_RECORDS / 2)
+            flushRecords(fp);
+    }
+
+    flushRecords(fp);
+    fprintf(fp, "# close\n");
+    proto->close();
+    ProtocolRegistry::destroy(proto);
+    flushRecords(fp);
+    return true;
+}
+
+static RFProtocol *mSlots[2];
+static u8  mStarted;
+
+// TDM slot handling of source.ino
+static void createSlot(u8 slot, u32 id)
+{
+    u16 hold;
+
+    mSlots[slot] = ProtocolRegistry::create(id, slot);
+    if (mSlots[slot] && mSlots[slot ^ 1]) {
+        hold = ProtocolRegistry::getShareTime(id, mSlots[slot ^ 1]->getProtoID());
+        mSlots[slot]->setRadioShare(hold);
+        mSlots[slot ^ 1]->setRadioShare(hold);
+    }
+}
+
+static void startSlot(u8 slot, u32 conID)
+{
+    mSlots[slot]->setControllerID(conID);
+    mSlots[slot]->init();
+    mStarted |= BV(slot);
+}
+
+static void deleteSlot(u8 slot)
+{
+    ProtocolRegistry::destroy(mSlots[slot]);
+    mSlots[slot] = NULL;
+    mStarted &= ~BV(slot);
+    if (mSlots[slot ^ 1]) {
+        mSlots[slot ^ 1]->setRadioShare(0);
+        if (mStarted & BV(slot ^ 1))
+            mSlots[slot ^ 1]->restoreRadio();
+    }
+}
+
+// a slot deleted next to one not started : only the reset of the deleted one is on the bus.
+// then both run interleaved, slot 0 is deleted half way and slot 1 gets the chip back
+static bool traceTDM(u32 ms, FILE *fp)
+{
+    u32 id, end, half, bindEnd, nextCtl = 0;
+    s8  idx = ProtocolRegistry::find(RFProtocol::buildID(RFProtocol::TX_NRF24L01, RFProtocol::PROTO_NRF24L01_SYMAX, 0));
+    PROTO_INFO_T info;
+
+    if (idx < 0)
+        return false;
+    ProtocolRegistry::getInfo(idx, &info);
+    id = RFProtocol::buildID(info.module, info.proto, 0);
+
+    HostShim::reset();
+    HostShim::eraseEEPROM();
+    Storage::begin();
+    RadioMock::setMISOCallback(misoModel);
+    mStarted = 0;
+
+    fprintf(fp, "# %.8s x2 %06x %u ms\n", info.name, (unsigned)id, (unsigned)ms);
+    createSlot(0, id);
+    createSlot(1, id);
+    fprintf(fp, "# delete slot 0, slot 1 not started\n");
+    deleteSlot(0);
+    flushRecords(fp);
+
+    createSlot(0, id);
+    fprintf(fp, "# start slot 0\n");
+    startSlot(0, CONTROLLER_ID);
+    flushRecords(fp);
+    fprintf(fp, "# start slot 1\n");
+    startSlot(1, TDM_CONTROLLER_ID);
+    flushRecords(fp);
+
+    bindEnd = HostShim::getTime() + BIND_MS * 1000;
+    half    = HostShim::getTime() + ms * 500;
+    end     = HostShim::getTime() + ms * 1000;
+    while (HostShim::getTime() < end) {
+        if (bindEnd && HostShim::getTime() >= bindEnd) {
+            flushRecords(fp);
+            fprintf(fp, "# stop bind %d %d\n", mSlots[0]->stopBind(), mSlots[1]->stopBind());
+            bindEnd = 0;
+        }
+        if (half && HostShim::getTime() >= half) {
+            flushRecords(fp);
+            fprintf(fp, "# delete slot 0\n");
+            deleteSlot(0);
+            half = 0;
+        }
+        if (HostShim::getTime() >= nextCtl) {
+            for (u8 i = 0; i < 2; i++) {
+                if (mSlots[i])
+                    injectScript(mSlots[i]);
+            }
+            nextCtl += CONTROL_PERIOD_uS;
+        }
+        for (u8 i = 0; i < 2; i++) {
+            if (mSlots[i])
+                mSlots[i]->loop();
+        }
+        Storage::poll();
+        HostShim::advance(HOST_STEP_uS);
+        if (RadioMock::getCount() >= MOCK_MAX_RECORDS / 2)
+            flushRecords(fp);
+    }
+
+    flushRecords(fp);
+    fprintf(fp, "# close\n");
+    mSlots[1]->close();
+    deleteSlot(1);
+    flushRecords(fp);
+    return true;
+}
+
+// the TDM trace follows the protocols
+static bool runTrace(u8 idx, u32 ms, FILE *fp)
+{
+    if (idx == ProtocolRegistry::getCount())
+        return traceTDM(ms, fp);
+    return trace(idx, ms, fp);
+}
+
+static void getPath(char *path, int size, const char *dir, u8 idx)
+{
+    PROTO_INFO_T info;
+    char name[PROTO_NAME_LEN + 1];
+
+    if (idx == ProtocolRegistry::getCount()) {
+        snprintf(path, size, "%s/%s.trace", dir, TDM_TRACE);
+        return;
+    }
+    ProtocolRegistry::getInfo(idx, &info);
+    memcpy(name, info.name, PROTO_NAME_LEN);
+    name[PROTO_NAME_LEN] = 0;
+    for (char *p = name; *p; p++) {
+        if (*p >= 'A' && *p <= 'Z')
+            *p += 'a' - 'A';
+    }
+    snprintf(path, size, "%s/%s.trace", dir, name);
+}
+
+// returns line number of the first difference, 0 if equal
+static u32 compare(FILE *a, FILE *b)
+{
+    char la[512], lb[512];
+    u32  line = 0;
+
+    while (1) {
+        char *ra = fgets(la, sizeof(la), a);
+        char *rb = fgets(lb, sizeof(lb), b);
+
+        line++;
+        if (!ra && !rb)
+            return 0;
+        if (!ra || !rb || strcmp(la, lb))
+            return line;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *outDir = NULL;
+    const char *chkDir = NULL;
+    char path[256];
+    int  one = -1;
+    int  fails = 0;
+    u32  ms = RUN_MS;
+
+    for (int i = 1; i < argc - 1; i++) {
+        if (!strcmp(argv[i], "-o"))
+            outDir = argv[++i];
+        else if (!strcmp(argv[i], "-c"))
+            chkDir = argv[++i];
+        else if (!strcmp(argv[i], "-p"))
+            one = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t"))
+            ms = strtoul(argv[++i], NULL, 0);
+    }
+
+    for (u8 i = 0; i <= ProtocolRegistry::getCount(); i++) {
+        FILE *fp;
+
+        if (one >= 0 && one != i)
+            continue;
+
+        if (outDir) {
+            getPath(path, sizeof(path), outDir, i);
+            fp = fopen(path, "w");
+            if (!fp) {
+                fprintf(stderr, "%s : can not write\n", path);
+                return 2;
+            }
+            runTrace(i, ms, fp);
+            fclose(fp);
+        } else if (chkDir) {
+            FILE *golden;
+            u32  line;
+
+            getPath(path, sizeof(path), chkDir, i);
+            golden = fopen(path, "r");
+            if (!golden) {
+                fprintf(stderr, "%s : missing\n", path);
+                fails++;
+                continue;
+            }
+            fp = tmpfile();
+            runTrace(i, ms, fp);
+            rewind(fp);
+            line = compare(fp, golden);
+            if (line) {
+                fprintf(stdout, "%s : differs at line %u\n", path, (unsigned)line);
+                fails++;
+            } else {
+                fprintf(stdout, "%s : ok\n", path);
+            }
+            fclose(fp);
+            fclose(golden);
+        } else {
+            runTrace(i, ms, stdout);
+        }
+    }
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,578 @@
+/*
+ This project is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ see <http://www.gnu.org/licenses/>
+*/
+
+// load test of the SerialProtocol framing over a pseudo terminal.
+// a child process runs the host build of the parser on the master side, bytes go into the RX
+// vector at the line rate and handleRX() is called once per emulated loop() like in source.ino.
+// the parent streams command frames to the slave side with faults and matches the responses.
+//
+//   ./serial_bench                     one run with the defaults, result line
+//   -r fps                             frames/s, default RATE
+//   -R from:to:step                    sweep of rates, a line per rate
+//   -g count                           frames sent back to back at once, rate kept
+//   -t ms                              stream time
+//   -m name:weight,...                 command mix of controls, info, telemetry, failsafe, max
+//   -d %  -c %  -n %                   frames with a byte dropped, a byte corrupted, garbage before
+//   -u baud                            line rate of the device, 0 : unlimited
+//   -l us                              time of one loop() besides handleRX()
+//   -s seed
+//   -D                                 device side only on a pty until killed, for host applications
+//
+// the device answers every frame with its sequence and whether the payload is intact, so
+// a frame passing the checksum with wrong data counts as a false accept.
+// resync is the time from a faulted frame to the next accepted one.
+
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "HostShim.h"
+#include "SerialProtocol.h"
+
+#define RATE                200
+#define RUN_MS              3000
+#define DRAIN_MS            300             // responses still coming after the stream
+#define BAUD                57600
+#define LOOP_uS             500
+#define SEQ_SIZE            4               // u32 sequence leads every payload
+
+enum {
+    FAULT_NONE,
+    FAULT_DROP,
+    FAULT_CORRUPT,
+    FAULT_NOISE,
+};
+
+typedef struct {
+    const char *name;
+    u8   cmd;
+    u8   size;                              // payload, SEQ_SIZE at least
+} MIX_T;
+
+static const MIX_T TBL_MIX[] = {
+    { "controls",  SerialProtocol::CMD_INJECT_CONTROLS, 24              },
+    { "info",      SerialProtocol::CMD_GET_INFO,        SEQ_SIZE        },
+    { "telemetry", SerialProtocol::CMD_GET_TELEMETRY,   SEQ_SIZE        },
+    { "failsafe",  SerialProtocol::CMD_SET_FAILSAFE,    26              },
+    { "max",       SerialProtocol::CMD_INJECT_CONTROLS, MAX_PACKET_SIZE },
+};
+#define MIX_COUNT   (sizeof(TBL_MIX) / sizeof(TBL_MIX[0]))
+
+typedef struct {
+    u32  rate;
+    u32  group;
+    u32  runMs;
+    u32  weights[MIX_COUNT];
+    u32  drop;                              // % of frames
+    u32  corrupt;
+    u32  noise;
+    u32  baud;
+    u32  loopUs;
+    u32  seed;
+} CONFIG_T;
+
+typedef struct {
+    u64  sendUs;
+    u64  respUs;                            // 0 : no response
+    u8   fault;
+    u8   intact;
+} FRAME_REC_T;
+
+static SerialProtocol mSerial;
+
+static u64 nowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static u8 pattern(u32 seq, u8 cmd, u8 idx)
+{
+    return (u8)(seq * 7 + idx * 13 + cmd);
+}
+
+//
+// device side
+//
+static u32 deviceCallback(u8 cmd, u8 *data, u8 size)
+{
+    u8  resp[SEQ_SIZE + 1];
+    u32 seq = 0;
+    u8  intact = (size >= SEQ_SIZE);
+
+    if (intact)
+        memcpy(&seq, data, SEQ_SIZE);
+    for (u8 i = SEQ_SIZE; intact && i < size; i++)
+        intact = (data[i] == pattern(seq, cmd, i));
+
+    memcpy(resp, &seq, SEQ_SIZE);
+    resp[SEQ_SIZE] = intact;
+    mSerial.sendResponse(true, cmd, resp, sizeof(resp));
+    return intact;
+}
+
+static void runDevice(int fd, u32 baud, u32 loopUs)
+{
+    std::deque<u8> wire;
+    u8  buf[256];
+    u32 byteUs = baud ? 10000000UL / baud : 0;
+    u64 lineUs = 0;                         // end of the last byte put into the RX vector
+    u64 start, now;
+    int size;
+
+    HostShim::reset();
+    mSerial.begin(baud ? baud : BAUD);
+    mSerial.setCallback(deviceCallback);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    for (;;) {
+        start = nowUs();
+        do {
+            size = read(fd, buf, sizeof(buf));
+            if (size == 0 || (size < 0 && errno != EAGAIN && errno != EINTR))
+                return;                     // the slave is closed
+            now = nowUs();
+            if (size > 0 && wire.empty() && lineUs < now)
+                lineUs = now;
+            for (int i = 0; i < size; i++)
+                wire.push_back(buf[i]);
+
+            // bytes complete on the wire go through the vector even while loop() is busy
+            while (!wire.empty() && (!byteUs || lineUs + byteUs <= now)) {
+                HostShim::receive(wire.front());
+                wire.pop_front();
+                lineUs += byteUs;
+            }
+        } while (now < start + loopUs);
+
+        mSerial.handleRX();
+        size = HostShim::transmit(buf, sizeof(buf));
+        if (size > 0 && write(fd, buf, size) < 0)
+            return;
+    }
+}
+
+//
+// host side
+//
+static u8 pickCommand(const CONFIG_T *cfg)
+{
+    u32 total = 0;
+    u32 r;
+
+    for (u8 i = 0; i < MIX_COUNT; i++)
+        total += cfg->weights[i];
+    r = rand() % total;
+    for (u8 i = 0; i < MIX_COUNT; i++) {
+        if (r < cfg->weights[i])
+            return i;
+        r -= cfg->weights[i];
+    }
+    return 0;
+}
+
+static bool hit(u32 percent)
+{
+    return (u32)(rand() % 100) < percent;
+}
+
+// a frame with its fault, returns the size
+static u8 buildFrame(const CONFIG_T *cfg, u32 seq, u8 *frame, u8 *fault)
+{
+    const MIX_T *mix = &TBL_MIX[pickCommand(cfg)];
+    u8 size = 0;
+    u8 sum;
+
+    *fault = FAULT_NONE;
+    if (hit(cfg->noise)) {
+        u8 cnt = 1 + rand() % 8;
+        const u8 header[] = { '$', 'M', '<' };
+
+        // headers in the garbage are the hard case for the parser
+        for (u8 i = 0; i < cnt; i++)
+            frame[size++] = (rand() & 1) ? header[i % 3] : rand();
+        *fault = FAULT_NOISE;
+    }
+
+    u8 head = size;
+    frame[size++] = '$';
+    frame[size++] = 'M';
+    frame[size++] = '<';
+    frame[size++] = mix->size;
+    frame[size++] = mix->cmd;
+    sum = mix->size ^ mix->cmd;
+    for (u8 i = 0; i < mix->size; i++) {
+        u8 data = (i < SEQ_SIZE) ? (u8)(seq >> (i * 8)) : pattern(seq, mix->cmd, i);
+        frame[size++] = data;
+        sum ^= data;
+    }
+    frame[size++] = sum;
+
+    if (hit(cfg->drop)) {
+        u8 pos = head + rand() % (size - head);
+        memmove(&frame[pos], &frame[pos + 1], size - pos - 1);
+        size--;
+        *fault = FAULT_DROP;
+    } else if (hit(cfg->corrupt)) {
+        frame[head + rand() % (size - head)] ^= 1 + rand() % 255;
+        *fault = FAULT_CORRUPT;
+    }
+    return size;
+}
+
+typedef struct {
+    u8   state;
+    u8   size;
+    u8   cmd;
+    u8   offset;
+    u8   sum;
+    u8   data[256];
+} PARSER_T;
+
+// response frames $M> or $M! size cmd data checksum of size to data
+static bool parseResponse(PARSER_T *p, u8 ch)
+{
+    switch (p->state) {
+        case 0: p->state = (ch == '$') ? 1 : 0;                    break;
+        case 1: p->state = (ch == 'M') ? 2 : 0;                    break;
+        case 2: p->state = (ch == '>' || ch == '!') ? 3 : 0;       break;
+        case 3: p->size = ch; p->sum = ch; p->offset = 0; p->state = 4; break;
+        case 4: p->cmd = ch; p->sum ^= ch; p->state = 5;           break;
+        case 5:
+            if (p->offset < p->size) {
+                p->data[p->offset++] = ch;
+                p->sum ^= ch;
+            } else {
+                p->state = 0;
+                return p->sum == ch;
+            }
+            break;
+    }
+    return false;
+}
+
+typedef struct {
+    u32  sent;
+    u32  accepted;
+    u32  lost;                              // clean frames without a response
+    u32  falseAccepts;
+    u32  faults;
+    u32  stray;                             // responses to unknown sequences
+    u32  fps;
+    u32  latency[4];                        // us : p50, p90, p99, max
+    u32  resyncAvg;                         // us
+    u32  resyncMax;
+    u32  resyncFrames;                      // clean frames lost after a fault, max
+} RESULT_T;
+
+static void readResponses(int fd, PARSER_T *parser, std::vector<FRAME_REC_T> &recs, RESULT_T *res)
+{
+    u8  buf[256];
+    int size;
+    u32 seq;
+
+    while ((size = read(fd, buf, sizeof(buf))) > 0) {
+        u64 now = nowUs();
+
+        for (int i = 0; i < size; i++) {
+            if (!parseResponse(parser, buf[i]) || parser->size <= SEQ_SIZE)
+                continue;
+            memcpy(&seq, parser->data, SEQ_SIZE);
+            if (seq >= recs.size() || recs[seq].respUs) {
+                res->stray++;
+                continue;
+            }
+            recs[seq].respUs = now;
+            recs[seq].intact = parser->data[SEQ_SIZE];
+        }
+    }
+}
+
+static u32 percentile(std::vector<u32> &v, u32 per)
+{
+    if (v.empty())
+        return 0;
+    return v[(v.size() - 1) * per / 100];
+}
+
+static void summarize(const CONFIG_T *cfg, std::vector<FRAME_REC_T> &recs, RESULT_T *res)
+{
+    std::vector<u32> latency;
+    u64 resyncSum = 0;
+    u32 resyncCnt = 0;
+
+    res->sent = recs.size();
+    for (u32 i = 0; i < recs.size(); i++) {
+        FRAME_REC_T *rec = &recs[i];
+
+        if (rec->fault)
+            res->faults++;
+        if (rec->respUs && !rec->intact) {
+            res->falseAccepts++;
+        } else if (rec->respUs) {
+            res->accepted++;
+            latency.push_back(rec->respUs - rec->sendUs);
+        } else if (!rec->fault) {
+            res->lost++;
+        }
+    }
+    std::sort(latency.begin(), latency.end());
+    res->latency[0] = percentile(latency, 50);
+    res->latency[1] = percentile(latency, 90);
+    res->latency[2] = percentile(latency, 99);
+    res->latency[3] = percentile(latency, 100);
+    res->fps = (u64)res->accepted * 1000 / cfg->runMs;
+
+    for (u32 i = 0; i < recs.size(); i++) {
+        u32 lost = 0;
+        u32 j;
+
+        if (!recs[i].fault)
+            continue;
+        for (j = i + 1; j < recs.size() && !(recs[j].respUs && recs[j].intact); j++) {
+            if (!recs[j].fault)
+                lost++;
+        }
+        if (j >= recs.size())
+            continue;
+        u32 us = recs[j].sendUs - recs[i].sendUs;
+        resyncSum += us;
+        resyncCnt++;
+        if (us > res->resyncMax)
+            res->resyncMax = us;
+        if (lost > res->resyncFrames)
+            res->resyncFrames = lost;
+    }
+    res->resyncAvg = resyncCnt ? resyncSum / resyncCnt : 0;
+}
+
+static int openPty(int *slave)
+{
+    struct termios tio;
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) || unlockpt(master))
+        return -1;
+    *slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (*slave < 0)
+        return -1;
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+    return master;
+}
+
+static bool runBench(const CONFIG_T *cfg, RESULT_T *res)
+{
+    std::vector<FRAME_REC_T> recs;
+    PARSER_T parser;
+    u8   frame[64];
+    int  master, slave;
+    pid_t pid;
+    u64  start, next, end;
+    u64  period = (u64)1000000 * cfg->group / cfg->rate;
+
+    memset(res, 0, sizeof(*res));
+    memset(&parser, 0, sizeof(parser));
+    master = openPty(&slave);
+    if (master < 0) {
+        perror("pty");
+        return false;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        close(slave);
+        runDevice(master, cfg->baud, cfg->loopUs);
+        _exit(0);
+    }
+    close(master);
+    fcntl(slave, F_SETFL, fcntl(slave, F_GETFL) | O_NONBLOCK);
+    srand(cfg->seed);
+
+    start = nowUs();
+    end   = start + (u64)cfg->runMs * 1000;
+    next  = start;
+    while (nowUs() < end + DRAIN_MS * 1000) {
+        u64 now = nowUs();
+        struct pollfd pfd = { slave, POLLIN, 0 };
+        struct timespec ts;
+
+        if (now >= next && now < end) {
+            for (u32 i = 0; i < cfg->group; i++) {
+                FRAME_REC_T rec;
+                u8 size = buildFrame(cfg, recs.size(), frame, &rec.fault);
+
+                rec.sendUs = nowUs();
+                rec.respUs = 0;
+                rec.intact = 0;
+                recs.push_back(rec);
+                if (write(slave, frame, size) < 0 && errno != EAGAIN)
+                    perror("write");
+            }
+            next += period;
+            continue;
+        }
+
+        u64 wait = (now < next && next < end) ? next - now : 1000;
+        ts.tv_sec  = wait / 1000000;
+        ts.tv_nsec = (wait % 1000000) * 1000;
+        if (ppoll(&pfd, 1, &ts, NULL) > 0)
+            readResponses(slave, &parser, recs, res);
+    }
+
+    close(slave);
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    summarize(cfg, recs, res);
+    return true;
+}
+
+static void printHeader(void)
+{
+    fprintf(stdout, "%6s %7s %7s %6s %6s %5s %6s %5s %7s %7s %7s %7s %8s %8s %5s\n",
+            "rate", "sent", "accept", "fps", "lost", "false", "faults", "stray",
+            "p50us", "p90us", "p99us", "maxus", "resyncus", "resmaxus", "resfr");
+}
+
+static void printResult(const CONFIG_T *cfg, const RESULT_T *res)
+{
+    fprintf(stdout, "%6u %7u %7u %6u %6u %5u %6u %5u %7u %7u %7u %7u %8u %8u %5u\n",
+            cfg->rate, res->sent, res->accepted, res->fps, res->lost, res->falseAccepts, res->faults,
+            res->stray, res->latency[0], res->latency[1], res->latency[2], res->latency[3],
+            res->resyncAvg, res->resyncMax, res->resyncFrames);
+}
+
+static bool parseMix(CONFIG_T *cfg, char *arg)
+{
+    memset(cfg->weights, 0, sizeof(cfg->weights));
+    for (char *tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+        char *sep = strchr(tok, ':');
+        u8 i;
+
+        if (sep)
+            *sep++ = 0;
+        for (i = 0; i < MIX_COUNT && strcmp(tok, TBL_MIX[i].name); i++)
+            ;
+        if (i >= MIX_COUNT)
+            return false;
+        cfg->weights[i] = sep ? strtoul(sep, NULL, 0) : 1;
+    }
+    for (u8 i = 0; i < MIX_COUNT; i++) {
+        if (cfg->weights[i])
+            return true;
+    }
+    return false;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "serial_bench [-r fps | -R from:to:step] [-g count] [-t ms] [-m mix] [-d %%] [-c %%] [-n %%]\n"
+                    "             [-u baud] [-l us] [-s seed] [-D]\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    CONFIG_T cfg;
+    RESULT_T res;
+    u32  from = 0, to = 0, step = 1;
+    bool device = false;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.rate    = RATE;
+    cfg.group   = 1;
+    cfg.runMs   = RUN_MS;
+    cfg.baud    = BAUD;
+    cfg.loopUs  = LOOP_uS;
+    cfg.seed    = 1;
+    cfg.weights[0] = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-D")) {
+            device = true;
+            continue;
+        }
+        if (argv[i][0] != '-' || i + 1 >= argc)
+            usage();
+        char *arg = argv[++i];
+        switch (argv[i - 1][1]) {
+            case 'r': cfg.rate    = strtoul(arg, NULL, 0);  break;
+            case 'g': cfg.group   = strtoul(arg, NULL, 0);  break;
+            case 't': cfg.runMs   = strtoul(arg, NULL, 0);  break;
+            case 'd': cfg.drop    = strtoul(arg, NULL, 0);  break;
+            case 'c': cfg.corrupt = strtoul(arg, NULL, 0);  break;
+            case 'n': cfg.noise   = strtoul(arg, NULL, 0);  break;
+            case 'u': cfg.baud    = strtoul(arg, NULL, 0);  break;
+            case 'l': cfg.loopUs  = strtoul(arg, NULL, 0);  break;
+            case 's': cfg.seed    = strtoul(arg, NULL, 0);  break;
+            case 'm':
+                if (!parseMix(&cfg, arg))
+                    usage();
+                break;
+            case 'R':
+                if (sscanf(arg, "%u:%u:%u", &from, &to, &step) != 3 || !step)
+                    usage();
+                break;
+            default:
+                usage();
+        }
+    }
+    if (!cfg.rate || !cfg.group || !cfg.runMs)
+        usage();
+
+    if (device) {
+        int slave;
+        int master = openPty(&slave);
+
+        if (master < 0) {
+            perror("pty");
+            return 1;
+        }
+        fprintf(stdout, "%s\n", ptsname(master));
+        fflush(stdout);
+        // the slave stays open here so the device outlives the host applications
+        runDevice(master, cfg.baud, cfg.loopUs);
+        return 0;
+    }
+
+    printHeader();
+    if (!from) {
+        from = to = cfg.rate;
+    }
+    for (u32 rate = from; rate <= to; rate += step) {
+        cfg.rate = rate;
+        if (!runBench(&cfg, &res))
+            return 1;
+        printResult(&cfg, &res);
+        fflush(stdout);
+    }
+    return 0;
+}